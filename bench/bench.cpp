@@ -0,0 +1,1165 @@
+/**
+ * Host benchmark for the LEDStripController render path.
+ * Runs every registered effect through Controller::mainloop() for a number of frames
+ * at several strip lengths and reports cost per frame.
+ *
+ * Usage: bench [frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "../src/LEDStripController.h"
+#include "../src/Effects.h"
+#include "../src/SPIWriters.h"
+
+using namespace LEDStripController;
+
+namespace
+{
+    const int stripLengths[] = { 60, 153, 1000, 5000 };
+
+    // Frames run before measuring, so effect state has moved away from its initial value
+    const int warmupFrames = 16;
+
+    struct Result
+    {
+        double nsPerFrame;
+        double eepromReads;
+        double eepromWrites;
+        double shows;
+        double hsvConversions;
+        double ledBytesWritten;
+        double ledBytesChanged;
+    };
+
+    /**
+     * Advance the simulated clock by one frame period at the controller's fps
+     */
+    void tick(Controller &C)
+    {
+        Host::advanceMicros(1000000UL / (C.getFPS() ? C.getFPS() : 1));
+    }
+
+    Result measure(Controller &C, int frames)
+    {
+        Result r;
+        CRGB *leds = C.getLEDs();
+        int numLEDs = C.getNumLEDs();
+
+        for (int f = 0; f < warmupFrames; f++) {
+            C.mainloop();
+            tick(C);
+        }
+
+        // Timed pass, counting EEPROM and show traffic
+        Host::resetCounters();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            C.mainloop();
+            tick(C);
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        r.nsPerFrame = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+        r.eepromReads = (double)Host::counters.eepromReads / frames;
+        r.eepromWrites = (double)Host::counters.eepromWrites / frames;
+        r.shows = (double)Host::counters.shows / frames;
+        r.hsvConversions = (double)Host::counters.hsvConversions / frames;
+
+        // Untimed pass measuring LED buffer traffic
+        std::vector<CRGB> previous(leds, leds + numLEDs);
+        unsigned long changed = 0;
+        Host::resetCounters();
+        Host::trackLEDWrites(leds, numLEDs * sizeof(CRGB));
+        for (int f = 0; f < frames; f++) {
+            C.mainloop();
+            tick(C);
+            for (int i = 0; i < numLEDs; i++) {
+                for (int c = 0; c < 3; c++) changed += leds[i].raw[c] != previous[i].raw[c];
+                previous[i] = leds[i];
+            }
+        }
+        Host::stopLEDTracking();
+
+        r.ledBytesWritten = (double)Host::counters.ledBytesWritten / frames;
+        r.ledBytesChanged = (double)changed / frames;
+        return r;
+    }
+
+    // Sinks for kernel results so the loops are not optimised away
+    volatile uint8_t kernelSink;
+    volatile uint8_t kernelScale;
+
+    /**
+     * Per-call cost of the color kernels used by the base effect functions,
+     * with the previous floating point fade and uncached HSV conversion as reference.
+     * Host floats are hardware, on AVR they are soft-float so the gap is much wider.
+     */
+    void kernelBench(int calls)
+    {
+        CRGB col(200, 100, 50);
+        CHSV hsv(100, 255, 255);
+        CRGB rgb;
+        std::chrono::steady_clock::time_point start, end;
+
+        printf("\nColor kernels, ns per call\n");
+
+        start = std::chrono::steady_clock::now();
+        for (int n = 0; n < calls; n++) {
+            uint8_t i = kernelScale + n;
+            CRGB c = col;
+            c.r = c.r * ((float)i / 255);
+            c.g = c.g * ((float)i / 255);
+            c.b = c.b * ((float)i / 255);
+            kernelSink = c.r ^ c.g ^ c.b;
+        }
+        end = std::chrono::steady_clock::now();
+        printf("%-28s %8.2f\n", "fade, float (previous)", std::chrono::duration<double, std::nano>(end - start).count() / calls);
+
+        start = std::chrono::steady_clock::now();
+        for (int n = 0; n < calls; n++) {
+            uint8_t i = kernelScale + n;
+            CRGB c = col;
+            c.nscale8(i);
+            kernelSink = c.r ^ c.g ^ c.b;
+        }
+        end = std::chrono::steady_clock::now();
+        printf("%-28s %8.2f\n", "fade, scale8", std::chrono::duration<double, std::nano>(end - start).count() / calls);
+
+        start = std::chrono::steady_clock::now();
+        for (int n = 0; n < calls; n++) {
+            hsv.v = kernelScale | 0xF0;
+            hsv2rgb_rainbow(hsv, rgb);
+            kernelSink = rgb.r ^ rgb.g ^ rgb.b;
+        }
+        end = std::chrono::steady_clock::now();
+        printf("%-28s %8.2f\n", "HSV to RGB (previous)", std::chrono::duration<double, std::nano>(end - start).count() / calls);
+
+        // Same comparison the base functions make before converting
+        CHSV cached = hsv;
+        start = std::chrono::steady_clock::now();
+        for (int n = 0; n < calls; n++) {
+            hsv.v = kernelScale | 0xF0;
+            if (hsv.h != cached.h || hsv.s != cached.s || hsv.v != cached.v) {
+                hsv2rgb_rainbow(hsv, rgb);
+                cached = hsv;
+            }
+            kernelSink = rgb.r ^ rgb.g ^ rgb.b;
+        }
+        end = std::chrono::steady_clock::now();
+        printf("%-28s %8.2f\n", "HSV to RGB, cached", std::chrono::duration<double, std::nano>(end - start).count() / calls);
+    }
+
+    /**
+     * Cost of a full Alternate fill redraw and show with 4 active colors (as after a color or index change),
+     * with the previous per-LED color lookup as reference.
+     */
+    void paletteBench(int frames)
+    {
+        printf("\nAlternate fill redraw, 4 colors, ns per redrawn frame\n");
+        printf("%-6s %12s %12s %8s\n", "LEDs", "per LED", "table", "match");
+
+        for (unsigned int l = 0; l < sizeof(stripLengths) / sizeof(stripLengths[0]); l++) {
+            int numLEDs = stripLengths[l];
+            std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+
+            Host::reset();
+            FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+            Controller C;
+            C.setLEDs(leds.data(), numLEDs);
+            for (int i = 0; i < 4; i++) C.setColor(CRGB(i * 60, 255 - i * 60, i * 20), i);
+            C.setMaximumColorIndex(3);
+            C.setEffect(Effects::colorAlternateFill.id);
+            C.setColorIndexOffset(1);
+
+            // Previous implementation, two modulos and a color lookup per LED
+            std::vector<CRGB> reference(numLEDs);
+            int first = C.getMinimumColorIndex();
+            int numCols = C.getMaximumColorIndex() + 1 - first;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int f = 0; f < frames; f++) {
+                int offset = C.getColorIndexOffset();
+                for (int i = 0; i < numLEDs; i++) reference[i] = C.getColor(((i % numCols) + offset) % numCols + first);
+                FastLED.show();
+            }
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            double perLED = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+
+            start = std::chrono::steady_clock::now();
+            for (int f = 0; f < frames; f++) {
+                C.redraw();
+                tick(C);
+                C.mainloop();
+            }
+            end = std::chrono::steady_clock::now();
+            double table = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+
+            // The offset moves every 255 frames, compare against the pattern for the current one
+            int offset = C.getColorIndexOffset();
+            for (int i = 0; i < numLEDs; i++) reference[i] = C.getColor(((i % numCols) + offset) % numCols + first);
+            bool match = memcmp((const void*)leds.data(), (const void*)reference.data(), numLEDs * sizeof(CRGB)) == 0;
+            printf("%-6d %12.0f %12.0f %8s\n", numLEDs, perLED, table, match ? "yes" : "NO");
+        }
+    }
+
+    /**
+     * Simulate a host dragging a brightness slider: one setBrightness call per frame,
+     * then idle frames until the controller has committed its settings.
+     */
+    void settingsBurst(int changes)
+    {
+        std::vector<CRGB> leds(153, CRGB(0, 0, 0));
+
+        Host::reset();
+        FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), leds.size());
+        Controller C;
+        C.setLEDs(leds.data(), leds.size());
+        Host::resetCounters();
+
+        unsigned long maxFrameWrites = 0;
+        for (int f = 0; f < changes; f++) {
+            unsigned long before = Host::counters.eepromWrites;
+            C.setBrightness(f & 0xFF);
+            C.mainloop();
+            tick(C);
+            unsigned long frameWrites = Host::counters.eepromWrites - before;
+            if (frameWrites > maxFrameWrites) maxFrameWrites = frameWrites;
+        }
+        unsigned long burstWrites = Host::counters.eepromWrites;
+
+        int idleFrames = 0;
+        while (C.hasUnsavedChanges()) {
+            C.mainloop();
+            tick(C);
+            idleFrames++;
+        }
+
+        printf("\nSettings: %d brightness changes, one per frame\n", changes);
+        printf("EEPROM bytes written during burst: %lu (max %lu in one frame)\n", burstWrites, maxFrameWrites);
+        printf("EEPROM bytes written in total: %lu, committed after %d idle frames\n",
+               Host::counters.eepromWrites, idleFrames);
+    }
+
+    /**
+     * Animation speed at several frame rates and speed settings, using the Rainbow shift effect (one hue per step).
+     * The loop calls mainloop continuously, each pass costing loopMicros of simulated time,
+     * and each drawn frame costs renderMicros more, simulating a strip too long to reach the requested fps.
+     * steps/s should match the expected rate whatever the frame rate, per-frame is the rate if effects stepped once per frame.
+     */
+    void timingBench(unsigned long seconds)
+    {
+        struct Case { uint8_t fps; uint8_t speed; unsigned long renderMicros; };
+        const Case cases[] = {
+            { 15, 100, 0 }, { 30, 100, 0 }, { 60, 100, 0 }, { 120, 100, 0 },
+            { 60, 50, 0 }, { 60, 200, 0 }, { 60, 100, 40000 }
+        };
+        const unsigned long loopMicros = 100;
+        std::vector<CRGB> leds(153, CRGB(0, 0, 0));
+
+        printf("\nAnimation timing, Rainbow shift for %lu simulated seconds, %luus per loop pass\n", seconds, loopMicros);
+        printf("%-5s %6s %10s %8s %10s %10s %10s %8s\n", "fps", "speed", "render us", "frames/s", "per-frame", "steps/s", "expected", "error %");
+
+        for (unsigned int c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+            Host::reset();
+            FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), leds.size());
+            Controller C;
+            C.setLEDs(leds.data(), leds.size());
+            C.setEffect(Effects::rainbowCycle.id);
+            C.setFPS(cases[c].fps);
+            C.setSpeed(cases[c].speed);
+            C.mainloop();
+
+            unsigned long frames = 0, steps = 0;
+            uint8_t hue = C.getState().hue;
+            unsigned long end = Host::now() + seconds * 1000000UL;
+            while (Host::now() < end) {
+                if (C.mainloop()) {
+                    frames++;
+                    steps += (uint8_t)(C.getState().hue - hue);
+                    hue = C.getState().hue;
+                    Host::advanceMicros(cases[c].renderMicros);
+                }
+                Host::advanceMicros(loopMicros);
+            }
+
+            double expected = Effects::rainbowCycle.speed * cases[c].speed / 100.0;
+            double rate = (double)steps / seconds;
+            printf("%-5u %5u%% %10lu %8.1f %10.1f %10.1f %10.1f %8.2f\n", cases[c].fps, cases[c].speed, cases[c].renderMicros,
+                   (double)frames / seconds, (double)frames / seconds * cases[c].speed / 100.0, rate, expected, (rate - expected) * 100 / expected);
+        }
+    }
+
+    /**
+     * One strip split into segments with different effects, against the whole strip running one effect.
+     * Every segment is drawn in the same frame, so there is still at most one FastLED.show() per frame.
+     */
+    void segmentBench(int frames)
+    {
+        const int numLEDs = 300;
+        const uint8_t segmentEffects[] = { Effects::rainbowSpinCycle.id, Effects::colorFillEmpty.id, Effects::colorFade.id };
+        const int numSegments = sizeof(segmentEffects) / sizeof(segmentEffects[0]);
+        std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+
+        printf("\nSegments, %d LEDs\n", numLEDs);
+        printf("%-28s %10s %8s\n", "layout", "ns/f", "shows");
+
+        for (int split = 0; split < 2; split++) {
+            Host::reset();
+            FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+            Controller C;
+            C.setLEDs(leds.data(), numLEDs);
+            C.setEffect(Effects::rainbowSpinCycle.id);
+
+            // Each segment needs its own EEPROM region for its settings
+            std::vector<Controller*> segments;
+            if (split) {
+                for (int s = 0; s < numSegments; s++) {
+                    Controller *segment = new Controller(SettingsStore::defaultLength * (s + 1), SettingsStore::defaultLength);
+                    segment->setEffect(segmentEffects[s]);
+                    segment->setBrightness(255);
+                    C.addSegment(*segment, s * numLEDs / numSegments, numLEDs / numSegments);
+                    segments.push_back(segment);
+                }
+                // The whole strip is covered by segments, so nothing shows through from the Controller's own effect
+                C.setEffect(Effects::colorFill.id);
+                C.setColor(0, 0, 0);
+            }
+
+            Result r = measure(C, frames);
+            printf("%-28s %10.0f %8.2f\n", split ? "3 segments (cycle/wipe/fade)" : "1 effect (cycle)", r.nsPerFrame, r.shows);
+
+            for (size_t s = 0; s < segments.size(); s++) delete segments[s];
+        }
+    }
+
+    /**
+     * How much of the hue wheel Rainbow fill spreads over the strip, with the previous 8 bit hue step (255 / LEDs) as reference.
+     * hues: distinct colors on the strip, last: hue of the last LED (the first is 0).
+     */
+    void rainbowBench()
+    {
+        printf("\nRainbow gradient, Rainbow fill from hue 0\n");
+        printf("%-6s %8s %8s %8s %8s\n", "LEDs", "8b hues", "8b last", "hues", "last");
+
+        for (unsigned int l = 0; l < sizeof(stripLengths) / sizeof(stripLengths[0]); l++) {
+            int numLEDs = stripLengths[l];
+            std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+
+            Host::reset();
+            FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+            Controller C;
+            C.setLEDs(leds.data(), numLEDs);
+            C.setEffect(Effects::rainbowFill.id);
+            C.mainloop();
+
+            // Each hue converts to its own color, so distinct colors count the hues drawn
+            int hues = 1;
+            for (int i = 1; i < numLEDs; i++) {
+                if (leds[i] != leds[i - 1]) hues++;
+            }
+            int lastHue = -1;
+            for (int h = 0; h < 256; h++) {
+                if (CRGB(CHSV(h, 255, 255)) == leds[numLEDs - 1]) lastHue = h;
+            }
+
+            int step8 = 255 / numLEDs;
+            printf("%-6d %8d %8d %8d %8d\n", numLEDs, step8 ? numLEDs : 1, step8 * (numLEDs - 1), hues, lastHue);
+        }
+    }
+
+    volatile uint8_t writerSink;
+
+    /**
+     * PixelWriter for IndexedFrame, standing in for a driver in the same way as the FastLED stand-in's show()
+     */
+    void hostWriter(const CRGB *pixels, uint8_t count, int first, int numLEDs)
+    {
+        uint8_t acc = 0;
+        unsigned long levels = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            acc ^= pixels[i].r ^ pixels[i].g ^ pixels[i].b;
+            levels += pixels[i].r + pixels[i].g + pixels[i].b;
+        }
+        writerSink = acc;
+        Host::counters.ledsShown += count;
+        Host::counters.levelsShown += levels;
+        Host::advanceMicros(count * Host::showMicrosPerLED());
+    }
+
+    /**
+     * Palette-indexed frames against CRGB LEDs: frame cost of the effects that support them (render + expand/show),
+     * through the host writer and through SPIWriters::apa102 (plus the simulated time on the wire at its SPI clock),
+     * and the longest strip each board's RAM can hold.
+     */
+    void indexedBench(int frames)
+    {
+        const int numLEDs = 1000;
+        const uint8_t effects[] = { Effects::colorFill.id, Effects::colorAlternateFill.id, Effects::colorFade.id,
+                                    Effects::colorFillEmpty.id, Effects::colorFillEmptyMiddle.id, Effects::randomFade.id };
+        std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+        std::vector<uint8_t> indices(numLEDs, 0);
+
+        printf("\nIndexed frames, %d LEDs, ns per frame including show\n", numLEDs);
+        printf("%-28s %10s %10s %10s %9s %7s\n", "effect", "CRGB", "indexed", "apa102", "wire us", "colors");
+
+        for (unsigned int e = 0; e < sizeof(effects) / sizeof(effects[0]); e++) {
+            double ns[3];
+            unsigned long wireMicros = 0;
+            int colors = 0;
+            for (int indexed = 0; indexed < 3; indexed++) {
+                Host::reset();
+                FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+                IndexedFrame frame(indices.data(), numLEDs, indexed == 2 ? SPIWriters::apa102 : hostWriter);
+                Controller C;
+                if (indexed) C.setLEDs(frame);
+                else C.setLEDs(leds.data(), numLEDs);
+                C.setColor(255, 0, 0, 0);
+                C.setColor(0, 255, 0, 1);
+                C.setColor(0, 0, 255, 2);
+                C.setColor(255, 255, 0, 3);
+                C.setMaximumColorIndex(3);
+                C.setEffect(effects[e]);
+
+                for (int f = 0; f < warmupFrames; f++) {
+                    C.mainloop();
+                    tick(C);
+                }
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int f = 0; f < frames; f++) {
+                    C.mainloop();
+                    // Drop the bytes kept by the stand-in
+                    if (indexed == 2) SPI.clear();
+                    tick(C);
+                }
+                std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                ns[indexed] = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+                if (indexed == 2) {
+                    unsigned long before = micros();
+                    C.show();
+                    wireMicros = micros() - before;
+                }
+                if (indexed) colors = frame.getNumColors();
+            }
+            int idx = Controller().findEffect(effects[e]);
+            printf("%-28s %10.0f %10.0f %10.0f %9lu %7d\n", Effects::all[idx].name, ns[0], ns[1], ns[2], wireMicros, colors);
+        }
+
+        // RAM left for LEDs once the core, serial buffers, Controller, SerialController and stack are allocated.
+        // An estimate for AVR builds, measure your own sketch and adjust.
+        const int reservedRAM = 1024;
+        // Palette and dithering error in the frame, and the scaled palette and chunk on the stack while it is shown
+        const int indexedRAM = IndexedFrame::paletteSize * sizeof(CRGB) * 3 + IndexedFrame::chunkSize * sizeof(CRGB);
+        const struct { const char *board; int ram; } boards[] = {
+            { "Uno/Nano (ATmega328P)", 2048 },
+            { "Leonardo (ATmega32U4)", 2560 },
+            { "Mega (ATmega2560)", 8192 }
+        };
+
+        printf("\nLongest strip per board, %d B reserved, indexed frames use %d B besides 1 B per LED\n", reservedRAM, indexedRAM);
+        printf("%-24s %6s %8s %8s\n", "board", "RAM", "CRGB", "indexed");
+        for (unsigned int b = 0; b < sizeof(boards) / sizeof(boards[0]); b++) {
+            int free = boards[b].ram - reservedRAM;
+            printf("%-24s %6d %8d %8d\n", boards[b].board, boards[b].ram, free / (int)sizeof(CRGB), free - indexedRAM);
+        }
+    }
+
+    volatile uint32_t powerSink;
+
+    /**
+     * Cost of the power budget: frames without a budget, with one (estimate kept as the effect draws,
+     * or measured after each changed frame for effects without EffectFlags::tracksPower),
+     * and without one plus a scan of the whole strip every frame as reference.
+     */
+    void powerBench(int frames)
+    {
+        const int lengths[] = { 1000, 5000 };
+        const uint8_t effects[] = { Effects::colorFill.id, Effects::colorFade.id, Effects::colorFillEmpty.id, Effects::rainbowSpinCycle.id };
+        // About a sixth of what a white strip draws
+        const int mAPerLED = 10;
+
+        printf("\nPower budget, ns per frame, %d mA per LED budget at full brightness\n", mAPerLED);
+        printf("%-6s %-28s %10s %10s %10s %8s\n", "LEDs", "effect", "off", "budget", "scan", "mA");
+
+        for (unsigned int l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            int numLEDs = lengths[l];
+            std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+
+            for (unsigned int e = 0; e < sizeof(effects) / sizeof(effects[0]); e++) {
+                double ns[3];
+                uint16_t draw = 0;
+                for (int mode = 0; mode < 3; mode++) {
+                    Host::reset();
+                    FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+                    Controller C;
+                    C.setLEDs(leds.data(), numLEDs);
+                    C.setBrightness(255);
+                    C.setEffect(effects[e]);
+                    if (mode == 1) C.setPowerBudget(numLEDs * mAPerLED);
+
+                    for (int f = 0; f < warmupFrames; f++) {
+                        C.mainloop();
+                        tick(C);
+                    }
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    for (int f = 0; f < frames; f++) {
+                        C.mainloop();
+                        if (mode == 2) {
+                            uint32_t sum = 0;
+                            for (int i = 0; i < numLEDs; i++) sum += leds[i].r + leds[i].g + leds[i].b;
+                            powerSink = sum;
+                        }
+                        tick(C);
+                    }
+                    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                    ns[mode] = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+                    if (mode == 1) draw = C.getPowerDraw();
+                }
+                int idx = Controller().findEffect(effects[e]);
+                printf("%-6d %-28s %10.0f %10.0f %10.0f %8u\n", numLEDs, Effects::all[idx].name, ns[0], ns[1], ns[2], draw);
+            }
+        }
+    }
+
+    const ColorCorrection benchCorrection = colorCorrection<220, 255, 176, 240>();
+
+    /**
+     * Cost of gamma and white balance correction (gamma 2.2, 255/176/240 white balance): uncorrected frames,
+     * corrected as colors are drawn, and uncorrected plus a table lookup per channel of every LED each frame as reference.
+     */
+    void correctionBench(int frames)
+    {
+        const int numLEDs = 1000;
+        const uint8_t effects[] = { Effects::colorFade.id, Effects::colorFillEmpty.id, Effects::rainbowCycle.id, Effects::rainbowSpinCycle.id };
+        std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+        std::vector<CRGB> out(numLEDs, CRGB(0, 0, 0));
+
+        printf("\nColor correction, %d LEDs, ns per frame\n", numLEDs);
+        printf("%-28s %10s %10s %10s\n", "effect", "none", "drawn", "every LED");
+
+        for (unsigned int e = 0; e < sizeof(effects) / sizeof(effects[0]); e++) {
+            double ns[3];
+            for (int mode = 0; mode < 3; mode++) {
+                Host::reset();
+                FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+                Controller C;
+                C.setLEDs(leds.data(), numLEDs);
+                C.setEffect(effects[e]);
+                if (mode == 1) C.setCorrection(&benchCorrection);
+
+                for (int f = 0; f < warmupFrames; f++) {
+                    C.mainloop();
+                    tick(C);
+                }
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int f = 0; f < frames; f++) {
+                    C.mainloop();
+                    if (mode == 2) {
+                        for (int i = 0; i < numLEDs; i++) {
+                            out[i].r = pgm_read_byte(benchCorrection.red + leds[i].r);
+                            out[i].g = pgm_read_byte(benchCorrection.green + leds[i].g);
+                            out[i].b = pgm_read_byte(benchCorrection.blue + leds[i].b);
+                        }
+                    }
+                    tick(C);
+                }
+                std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                ns[mode] = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+            }
+            int idx = Controller().findEffect(effects[e]);
+            printf("%-28s %10.0f %10.0f %10.0f\n", Effects::all[idx].name, ns[0], ns[1], ns[2]);
+        }
+    }
+
+    /**
+     * Temporal dithering at a low brightness.
+     * Frame cost and shows per frame without and with dithering, unchanged frames are sent every frame period while dithered
+     * (and CRGB LEDs are scaled and drawn again each frame). Without it FastLED's own dithering is left on, but FastLED.show()
+     * skips it below 100 fps.
+     * Then the average level the LEDs are shown at over many frames for dim colors, against the level scale8 would give
+     * without rounding down: without dithering anything below one step after scaling is lost.
+     */
+    void ditherBench(int frames)
+    {
+        const int numLEDs = 300;
+        const uint8_t brightness = 64;
+        const uint8_t effects[] = { Effects::colorFill.id, Effects::colorFade.id, Effects::rainbowCycle.id, Effects::rainbowSpinCycle.id };
+        std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+        std::vector<uint8_t> indices(numLEDs, 0);
+
+        printf("\nDithering, %d LEDs at brightness %u\n", numLEDs, brightness);
+        printf("%-28s %10s %8s %10s %8s\n", "effect", "off ns/f", "shows", "on ns/f", "shows");
+
+        for (unsigned int e = 0; e < sizeof(effects) / sizeof(effects[0]); e++) {
+            double ns[2];
+            double shows[2];
+            for (int dither = 0; dither < 2; dither++) {
+                Host::reset();
+                FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+                Controller C;
+                C.setLEDs(leds.data(), numLEDs);
+                C.setBrightness(brightness);
+                C.setDither(dither);
+                C.setEffect(effects[e]);
+
+                for (int f = 0; f < warmupFrames; f++) {
+                    C.mainloop();
+                    tick(C);
+                }
+                unsigned long shown = Host::counters.shows;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (int f = 0; f < frames; f++) {
+                    C.mainloop();
+                    tick(C);
+                }
+                std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                ns[dither] = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+                shows[dither] = (double)(Host::counters.shows - shown) / frames;
+            }
+            int idx = Controller().findEffect(effects[e]);
+            printf("%-28s %10.0f %8.2f %10.0f %8.2f\n", Effects::all[idx].name, ns[0], shows[0], ns[1], shows[1]);
+        }
+
+        const uint8_t values[] = { 1, 2, 3, 5, 10, 100 };
+        const int levelFrames = 256;
+
+        printf("\nAverage level shown over %d frames, single color fill at brightness %u\n", levelFrames, brightness);
+        printf("%-6s %8s %8s %8s %8s\n", "value", "scaled", "off", "CRGB", "indexed");
+
+        for (unsigned int v = 0; v < sizeof(values) / sizeof(values[0]); v++) {
+            double level[3];
+            for (int mode = 0; mode < 3; mode++) {
+                Host::reset();
+                FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+                IndexedFrame frame(indices.data(), numLEDs, hostWriter);
+                Controller C;
+                if (mode == 2) C.setLEDs(frame);
+                else C.setLEDs(leds.data(), numLEDs);
+                C.setBrightness(brightness);
+                C.setDither(mode != 0);
+                C.setColor(values[v], values[v], values[v], 0);
+                C.setEffect(Effects::colorFill.id);
+
+                C.mainloop();
+                tick(C);
+                Host::counters.ledsShown = 0;
+                Host::counters.levelsShown = 0;
+                for (int f = 0; f < levelFrames; f++) {
+                    C.mainloop();
+                    tick(C);
+                }
+                // Frames not sent stay on the LEDs at the last level sent
+                level[mode] = Host::counters.ledsShown ? (double)Host::counters.levelsShown / Host::counters.ledsShown / 3 : 0;
+            }
+            printf("%-6u %8.3f %8.3f %8.3f %8.3f\n", values[v], values[v] * (brightness + 1) / 256.0, level[0], level[1], level[2]);
+        }
+    }
+
+    /**
+     * Crossfade from a rainbow cycle to a color wipe, with transition buffers of decreasing resolution.
+     * ram: bytes used for transitions (buffer + outgoing effect state), ns/f: cost of a frame while the crossfade runs.
+     */
+    void transitionBench(int frames)
+    {
+        const int numLEDs = 300;
+        const int divisors[] = { 0, 1, 2, 4 };
+        std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+        std::vector<CRGB> buffer(numLEDs, CRGB(0, 0, 0));
+
+        printf("\nTransitions, %d LEDs, rainbow cycle to color wipe\n", numLEDs);
+        printf("%-12s %8s %10s %8s\n", "buffer", "ram", "ns/f", "shows");
+
+        for (unsigned int d = 0; d < sizeof(divisors) / sizeof(divisors[0]); d++) {
+            Host::reset();
+            FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+            Controller C;
+            C.setLEDs(leds.data(), numLEDs);
+            C.setEffect(Effects::rainbowSpinCycle.id);
+            // Longest transition, so it lasts the whole measurement (about 3900 frames at 60 fps)
+            if (divisors[d]) C.setTransition(buffer.data(), numLEDs / divisors[d], 65535);
+            C.setEffect(Effects::colorFillEmpty.id);
+
+            Result r = measure(C, frames);
+            char label[16];
+            if (divisors[d]) snprintf(label, sizeof label, "1/%d (%d px)", divisors[d], numLEDs / divisors[d]);
+            else snprintf(label, sizeof label, "none");
+            printf("%-12s %8u %10.0f %8.2f\n", label, (unsigned)C.getTransitionRAM(), r.nsPerFrame, r.shows);
+        }
+    }
+
+#if LEDCON_STATS
+    /**
+     * Output of the stats command for a strip too long to show at its fps, with a brightness change part way.
+     * Shows take 30us per LED (WS2812B). The host clock only moves in show, so parse and render read 0.
+     */
+    void statsBench(unsigned long seconds)
+    {
+        const int numLEDs = 600;
+        const unsigned long loopMicros = 100;
+        std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+
+        Host::reset();
+        Host::setShowMicrosPerLED(30);
+        Host::MemoryStream stream;
+        SerialController C(&stream);
+        C.setLEDs(FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs));
+        C.setEffect(Effects::rainbowCycle.id);
+        C.getStats().reset();
+
+        unsigned long end = Host::now() + seconds * 1000000;
+        while (Host::now() < end) {
+            C.mainloop();
+            Host::advanceMicros(loopMicros);
+            if (Host::now() >= end / 2 && C.getBrightness() != 40) stream.feed("b 40\r\n");
+        }
+        stream.clear();
+        stream.feed("stats\r\n");
+        C.mainloop();
+
+        printf("\nStats command, %d LEDs at %u fps, %lu simulated seconds, 30us per LED shown, %u bytes per Controller\n",
+               numLEDs, C.getFPS(), seconds, (unsigned)sizeof(Controller));
+        printf("<stage> <count> <min us> <avg us> <max us>\n%s", stream.output().c_str());
+    }
+#endif
+
+    /**
+     * Two strips on separate outputs: a short one at 60 fps and a long one (slow to show) at 30 fps.
+     * shared: two Controllers run one after the other, each FastLED.show() sends both strips at FastLED's brightness.
+     * manager: a StripManager, each Controller shows only its own output at its own brightness.
+     * Shows take 30us per LED (WS2812B), max gap is the longest time between two frames of a strip.
+     */
+    void stripBench(unsigned long seconds)
+    {
+        const int lengths[] = { 60, 1000 };
+        const uint8_t rates[] = { 60, 30 };
+        const uint8_t brightness[] = { 255, 32 };
+        const unsigned long loopMicros = 100;
+        std::vector<CRGB> short_(lengths[0], CRGB(0, 0, 0));
+        std::vector<CRGB> long_(lengths[1], CRGB(0, 0, 0));
+
+        printf("\nStrips, %lu simulated seconds, 30us per LED shown\n", seconds);
+        printf("%-8s %-6s %6s %6s %8s %10s %10s\n", "mode", "strip", "LEDs", "fps", "frames/s", "max gap ms", "brightness");
+
+        for (int managed = 0; managed < 2; managed++) {
+            Host::reset();
+            Host::setShowMicrosPerLED(30);
+            CLEDController &out0 = FastLED.addLeds<WS2812B, 8, GRB>(short_.data(), lengths[0]);
+            CLEDController &out1 = FastLED.addLeds<WS2812B, 9, GRB>(long_.data(), lengths[1]);
+
+            Controller a(0, SettingsStore::defaultLength), b(SettingsStore::defaultLength, SettingsStore::defaultLength);
+            Controller *strips[] = { &a, &b };
+            StripManager manager;
+            if (managed) {
+                a.setLEDs(out0);
+                b.setLEDs(out1);
+                manager.addStrip(a);
+                manager.addStrip(b);
+            } else {
+                a.setLEDs(short_.data(), lengths[0]);
+                b.setLEDs(long_.data(), lengths[1]);
+            }
+            for (int s = 0; s < 2; s++) {
+                strips[s]->setEffect(Effects::rainbowCycle.id);
+                strips[s]->setFPS(rates[s]);
+                strips[s]->setBrightness(brightness[s]);
+            }
+
+            unsigned long frames[2] = { 0, 0 }, last[2] = { Host::now(), Host::now() }, gap[2] = { 0, 0 };
+            unsigned long end = Host::now() + seconds * 1000000UL;
+            while (Host::now() < end) {
+                if (managed) manager.mainloop();
+                else { a.mainloop(); b.mainloop(); }
+                Host::advanceMicros(loopMicros);
+
+                for (int s = 0; s < 2; s++) {
+                    if (strips[s]->getFrames() == frames[s]) continue;
+                    frames[s] = strips[s]->getFrames();
+                    if (Host::now() - last[s] > gap[s]) gap[s] = Host::now() - last[s];
+                    last[s] = Host::now();
+                }
+            }
+
+            for (int s = 0; s < 2; s++) {
+                // Without an output every strip is sent at FastLED's brightness, the last one set
+                uint8_t shown = managed ? strips[s]->getBrightness() : FastLED.getBrightness();
+                printf("%-8s %-6d %6d %6u %8.1f %10.1f %6u/%-3u\n", managed ? "manager" : "shared", s, lengths[s], rates[s],
+                       (double)frames[s] / seconds, gap[s] / 1000.0, shown, brightness[s]);
+            }
+        }
+    }
+
+    /**
+     * Time from a command arriving until its effect is shown, at several fps settings.
+     * The loop calls mainloop continuously, each pass costing loopMicros of simulated time,
+     * and commands arrive at varying points within the frame period.
+     */
+    void latencyBench(int commands)
+    {
+        const uint8_t rates[] = { 5, 30, 60 };
+        const unsigned long loopMicros = 100;
+        std::vector<CRGB> leds(153, CRGB(0, 0, 0));
+
+        printf("\nCommand latency, %d brightness commands, %luus per loop pass\n", commands, loopMicros);
+        printf("latency: simulated us from the command arriving to FastLED.show(), passes: mainloop calls per frame\n");
+        printf("%-5s %10s %10s %10s %8s\n", "fps", "period us", "avg us", "max us", "passes");
+
+        for (unsigned int r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            Host::reset();
+            Host::MemoryStream stream;
+            FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), leds.size());
+            SerialController C(&stream);
+            C.setLEDs(leds.data(), leds.size());
+            C.setFPS(rates[r]);
+            unsigned long period = 1000000UL / rates[r];
+
+            unsigned long total = 0, most = 0, passes = 0, frames = 0;
+            for (int i = 0; i < commands; i++) {
+                // Idle for part of a frame period so the command lands at a different phase each time
+                unsigned long idle = Host::now() + random16() % period;
+                while (Host::now() < idle) {
+                    passes++;
+                    frames += C.mainloop();
+                    Host::advanceMicros(loopMicros);
+                }
+
+                stream.feed(i & 1 ? "b 10\r\n" : "b 20\r\n");
+                unsigned long sent = Host::now();
+                unsigned long shows = Host::counters.shows;
+                while (Host::counters.shows == shows) {
+                    passes++;
+                    frames += C.mainloop();
+                    Host::advanceMicros(loopMicros);
+                }
+
+                unsigned long latency = Host::now() - sent;
+                total += latency;
+                if (latency > most) most = latency;
+            }
+
+            printf("%-5u %10lu %10lu %10lu %8lu\n", rates[r], period, total / commands, most, frames ? passes / frames : 0);
+        }
+    }
+
+    /**
+     * Build a binary request frame, returns its length
+     */
+    size_t binaryFrame(uint8_t *out, uint8_t opcode, const uint8_t *payload, uint8_t len)
+    {
+        out[0] = BinaryCommands::sync;
+        out[1] = opcode;
+        out[2] = len;
+        memcpy(out + 3, payload, len);
+        out[len + 3] = crc8(out + 1, len + 2);
+        return len + 4;
+    }
+
+    /**
+     * Set-color commands per second over the text and binary protocols.
+     * Wire rate assumes 10 bits per byte (8N1) and is limited by the longer of the request and the reply.
+     * Host ns is the parse and apply cost measured here, with one frame drawn per batch.
+     */
+    void protocolBench(int commands)
+    {
+        const unsigned long bauds[] = { 9600, 115200 };
+        std::vector<CRGB> leds(153, CRGB(0, 0, 0));
+
+        printf("\nCommand protocols, %d set color commands (c <r> <g> <b> <index>)\n", commands);
+        printf("req/reply: bytes on the wire per command, cmd/s: commands per second limited by the wire at each baud\n");
+        printf("%-7s %6s %6s %10s", "proto", "req", "reply", "host ns");
+        for (unsigned int b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++) printf(" %9lu/s", bauds[b]);
+        printf("\n");
+
+        for (int binary = 0; binary < 2; binary++) {
+            Host::reset();
+            Host::MemoryStream stream;
+            FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), leds.size());
+            SerialController C(&stream);
+            C.setLEDs(leds.data(), leds.size());
+            C.setBinaryMode(binary);
+
+            std::string input;
+            for (int i = 0; i < commands; i++) {
+                uint8_t color[4] = { (uint8_t)i, (uint8_t)(i * 3), (uint8_t)(i * 7), (uint8_t)(i % maxColors) };
+                if (binary) {
+                    uint8_t frame[BinaryCommands::maxPayload + 4];
+                    size_t n = binaryFrame(frame, Opcodes::color, color, sizeof color);
+                    input.append((const char *)frame, n);
+                } else {
+                    char line[32];
+                    snprintf(line, sizeof line, "c %u %u %u %u\r\n", color[0], color[1], color[2], color[3]);
+                    input.append(line);
+                }
+            }
+            stream.feed((const uint8_t *)input.data(), input.size());
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            C.mainloop();
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+            double request = (double)input.size() / commands;
+            double reply = (double)stream.output().size() / commands;
+            double wire = request > reply ? request : reply;
+            printf("%-7s %6.1f %6.1f %10.0f", binary ? "binary" : "text", request, reply,
+                   std::chrono::duration<double, std::nano>(end - start).count() / commands);
+            for (unsigned int b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++) printf(" %11.0f", bauds[b] / 10.0 / wire);
+            printf("\n");
+        }
+    }
+
+    /**
+     * Time for the reply to a text command to leave the board, from the command being read.
+     * The stream stand-in advances the clock by the wire time at 9600 baud, plus a fixed time per write call
+     * for a serial bridge that sends each write as its own packet (7.5ms, one Bluetooth LE connection interval).
+     */
+    void replyBench()
+    {
+        const char *lines[] = { "c 2", "seg", "e 99", "c 0 0 0 9", "c 10 20 30 1", "b 80" };
+        const unsigned long bridgeMicros[] = { 0, 7500 };
+        std::vector<CRGB> leds(153, CRGB(0, 0, 0));
+
+        printf("\nReply latency, text commands at 9600 baud\n");
+        printf("writes: write calls per reply, ms: time to send the reply directly / through a bridge adding 7.5ms per write\n");
+        printf("%-14s %6s %6s %8s %8s\n", "command", "bytes", "writes", "ms", "bridge");
+
+        for (unsigned int l = 0; l < sizeof(lines) / sizeof(lines[0]); l++) {
+            unsigned long bytes = 0, writes = 0, micros[2];
+            for (unsigned int b = 0; b < sizeof(bridgeMicros) / sizeof(bridgeMicros[0]); b++) {
+                Host::reset();
+                Host::MemoryStream stream;
+                FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), leds.size());
+                SerialController C(&stream);
+                C.setLEDs(leds.data(), leds.size());
+                stream.setBaud(9600);
+                stream.setWriteMicros(bridgeMicros[b]);
+
+                stream.feed(lines[l]);
+                stream.feed("\r\n");
+                unsigned long start = Host::now();
+                C.readCommands();
+                micros[b] = Host::now() - start;
+                bytes = stream.output().size();
+                writes = stream.writeCalls();
+            }
+            printf("%-14s %6lu %6lu %8.1f %8.1f\n", lines[l], bytes, writes, micros[0] / 1000.0, micros[1] / 1000.0);
+        }
+    }
+
+    /**
+     * Switch scene with 8 commands sent one line at a time at 9600 baud, with and without a batch.
+     * mid-scene: frames shown while only part of the scene had been applied, reply b: bytes sent back.
+     */
+    void sceneBench()
+    {
+        const char *scene[] = { "e 3", "mic 0", "mac 3", "c 255 0 0 0", "c 0 255 0 1", "c 0 0 255 2", "c 255 255 0 3", "b 96" };
+        const int numLines = sizeof(scene) / sizeof(scene[0]);
+        const unsigned long baud = 9600;
+        std::vector<CRGB> leds(153, CRGB(0, 0, 0));
+
+        printf("\nScene change, %d commands at %lu baud\n", numLines, baud);
+        printf("%-8s %10s %10s %10s\n", "mode", "mid-scene", "reply b", "ms");
+
+        for (int batch = 0; batch < 2; batch++) {
+            Host::reset();
+            Host::MemoryStream stream;
+            FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), leds.size());
+            SerialController C(&stream);
+            C.setLEDs(leds.data(), leds.size());
+            C.mainloop();
+
+            std::vector<std::string> lines;
+            if (batch) lines.push_back("begin");
+            for (int i = 0; i < numLines; i++) lines.push_back(scene[i]);
+            if (batch) lines.push_back("commit");
+
+            Host::resetCounters();
+            stream.clear();
+            unsigned long start = Host::now();
+            unsigned long midScene = 0;
+            for (size_t i = 0; i < lines.size(); i++) {
+                std::string line = lines[i] + "\r\n";
+
+                // Keep looping while the line is on the wire
+                unsigned long sent = Host::now() + line.size() * 10 * 1000000UL / baud;
+                while (Host::now() < sent) {
+                    C.mainloop();
+                    Host::advanceMicros(100);
+                }
+                if (i > 0) midScene = Host::counters.shows;
+
+                stream.feed(line.c_str());
+                C.mainloop();
+            }
+            unsigned long elapsed = Host::now() - start;
+
+            printf("%-8s %10lu %10zu %10.1f\n", batch ? "batch" : "single", midScene, stream.output().size(), elapsed / 1000.0);
+        }
+    }
+
+    /**
+     * Raw pixel streaming: Adalight frames copied into the LEDs and shown.
+     * Frames per second are limited by the wire at each baud (8N1), host ns is the receive and show cost per frame.
+     */
+    void streamBench(int frames)
+    {
+        const int lengths[] = { 60, 153, 1000 };
+        const unsigned long bauds[] = { 115200, 500000, 1000000 };
+
+        printf("\nPixel streaming, %d Adalight frames\n", frames);
+        printf("bytes: frame length on the wire, fps: frames per second limited by the wire at each baud\n");
+        printf("%-6s %7s %8s %10s", "LEDs", "bytes", "shown", "host ns");
+        for (unsigned int b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++) printf(" %8lu/s", bauds[b]);
+        printf("\n");
+
+        for (unsigned int l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            int numLEDs = lengths[l];
+            std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+
+            Host::reset();
+            Host::MemoryStream stream;
+            FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+            SerialController C(&stream);
+            C.setLEDs(leds.data(), numLEDs);
+            C.setStreamMode(true);
+
+            std::string input;
+            for (int f = 0; f < frames; f++) {
+                uint8_t hi = (numLEDs - 1) >> 8, lo = (numLEDs - 1) & 0xFF;
+                uint8_t header[] = { 'A', 'd', 'a', hi, lo, (uint8_t)(hi ^ lo ^ 0x55) };
+                input.append((const char *)header, sizeof header);
+                for (int i = 0; i < numLEDs * 3; i++) input.push_back((char)(f + i));
+            }
+            stream.feed((const uint8_t *)input.data(), input.size());
+
+            Host::resetCounters();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            while (stream.available()) C.mainloop();
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+            double bytes = (double)input.size() / frames;
+            printf("%-6d %7.0f %8lu %10.0f", numLEDs, bytes, C.getPixelStream().getFrames(),
+                   std::chrono::duration<double, std::nano>(end - start).count() / frames);
+            for (unsigned int b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++) printf(" %10.1f", bauds[b] / 10.0 / bytes);
+            printf("\n");
+        }
+    }
+
+    /**
+     * Settings store boot cost and write amplification for several region lengths.
+     * Commits a mix of brightness (70%), effect (20%) and color (10%) changes one at a time.
+     */
+    void storeBench(int commits)
+    {
+        const uint16_t lengths[] = { SettingsStore::minLength, 256, 512, 1024 };
+        const int bootRuns = 100;
+
+        printf("\nSettings store, %d commits (70%% brightness, 20%% effect, 10%% color)\n", commits);
+        printf("boot: EEPROM bytes read / ns to load, wr: EEPROM bytes written, "
+               "ampl: bytes written per setting byte changed, wear: most writes to one cell\n");
+        printf("%-8s %6s %8s %10s %10s %8s %8s\n", "region", "slots", "boot rd", "boot ns", "wr", "ampl", "wear");
+
+        int brightnessCommits = 0;
+        for (unsigned int l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            Host::reset();
+            Controller C(0, lengths[l]);
+            Host::resetCounters();
+            memset(EEPROM.cellWrites, 0, sizeof EEPROM.cellWrites);
+
+            unsigned long logical = 0;
+            brightnessCommits = 0;
+            for (int i = 0; i < commits; i++) {
+                uint8_t pick = random8() % 10;
+                if (pick < 7) {
+                    C.setBrightness(i);
+                    logical += 1;
+                    brightnessCommits++;
+                } else if (pick < 9) {
+                    uint8_t id = C.getEffects()[i % C.getNumEffects()].id;
+                    if (C.getEffect() == id) continue;
+                    C.setEffect(id);
+                    logical += 1;
+                } else {
+                    C.setColor(CRGB(i, i * 3, i * 7), i % maxColors);
+                    logical += 3;
+                }
+                C.save();
+            }
+            unsigned long written = Host::counters.eepromWrites;
+
+            Host::resetCounters();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int r = 0; r < bootRuns; r++) {
+                SettingsStore S(0, lengths[l]);
+                S.load();
+            }
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+            printf("%-8u %6u %8lu %10.0f %10lu %8.2f %8lu\n",
+                   lengths[l], C.getStore().slots(), Host::counters.eepromReads / bootRuns,
+                   std::chrono::duration<double, std::nano>(end - start).count() / bootRuns,
+                   written, (double)written / logical, EEPROM.maxCellWrites());
+        }
+        printf("Version 1 fixed layout: most writes to one cell ~%d (brightness)\n", brightnessCommits);
+    }
+};
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 1000;
+    if (frames < 1) frames = 1;
+
+    printf("LEDStripController host benchmark, %d frames per effect\n", frames);
+    printf("ns/f: render + show, ee rd/wr: EEPROM bytes per frame, shows: FastLED.show() calls per frame "
+           "(unchanged frames are skipped),\nhsv: HSV to RGB conversions per frame, led wr/chg: LED buffer bytes assigned/changed per frame\n");
+
+    for (unsigned int l = 0; l < sizeof(stripLengths) / sizeof(stripLengths[0]); l++) {
+        int numLEDs = stripLengths[l];
+        std::vector<CRGB> leds(numLEDs, CRGB(0, 0, 0));
+
+        Host::reset();
+        FastLED.addLeds<WS2812B, 8, GRB>(leds.data(), numLEDs);
+
+        Controller C;
+        C.setLEDs(leds.data(), numLEDs);
+
+        printf("\n%d LEDs\n", numLEDs);
+        printf("%-3s %-26s %10s %8s %8s %7s %8s %10s %10s\n",
+               "id", "effect", "ns/f", "ee rd", "ee wr", "shows", "hsv", "led wr", "led chg");
+
+        for (int e = 0; e < C.getNumEffects(); e++) {
+            const Effect &effect = C.getEffects()[e];
+            C.setEffect(effect.id);
+            Result r = measure(C, frames);
+
+            // Names are in flash on a board, but PROGMEM is plain memory on the host
+            printf("%-3d %-26s %10.0f %8.2f %8.2f %7.2f %8.1f %10.1f %10.1f\n",
+                   effect.id, effect.name ? effect.name : "?",
+                   r.nsPerFrame, r.eepromReads, r.eepromWrites, r.shows, r.hsvConversions,
+                   r.ledBytesWritten, r.ledBytesChanged);
+        }
+    }
+
+    kernelBench(1000000);
+    paletteBench(frames);
+    settingsBurst(100);
+    timingBench(10);
+    segmentBench(frames);
+    rainbowBench();
+    indexedBench(frames);
+    powerBench(frames);
+    correctionBench(frames);
+    ditherBench(frames);
+    transitionBench(frames);
+#if LEDCON_STATS
+    statsBench(10);
+#endif
+    stripBench(10);
+    latencyBench(50);
+    protocolBench(1000);
+    replyBench();
+    streamBench(100);
+    sceneBench();
+    storeBench(2000);
+    return 0;
+}
@@ -0,0 +1,116 @@
+#ifndef HOST_Arduino_h
+#define HOST_Arduino_h
+
+/**
+ * Host stand-in for the parts of the Arduino core used by this library.
+ * Only intended for building src/ natively for benchmarking, never for a board.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define F(str) (str)
+
+#pragma region Timing and random
+
+/**
+ * @brief Milliseconds since start, driven by the simulated clock in Host.h
+ */
+unsigned long millis();
+
+/**
+ * @brief Microseconds since start, driven by the simulated clock in Host.h
+ */
+unsigned long micros();
+
+/**
+ * @brief Advance the simulated clock instead of sleeping
+ */
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+#pragma endregion
+
+#pragma region Print / Stream
+
+/**
+ * Subset of the Arduino Print class.
+ * All output is funnelled through write(const uint8_t*, size_t) so stand-ins can count calls.
+ */
+class Print
+{
+private:
+    size_t printNumber(unsigned long n, uint8_t base);
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+    virtual int availableForWrite() { return 0; }
+
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(unsigned char n, int base = DEC);
+    size_t print(int n, int base = DEC);
+    size_t print(unsigned int n, int base = DEC);
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+
+    size_t println();
+    size_t println(const char *str);
+    size_t println(char c);
+    size_t println(unsigned char n, int base = DEC);
+    size_t println(int n, int base = DEC);
+    size_t println(unsigned int n, int base = DEC);
+    size_t println(long n, int base = DEC);
+    size_t println(unsigned long n, int base = DEC);
+};
+
+/**
+ * Subset of the Arduino Stream class.
+ */
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+
+    size_t readBytes(uint8_t *buffer, size_t length);
+    size_t readBytes(char *buffer, size_t length) { return readBytes((uint8_t *)buffer, length); }
+};
+
+#pragma endregion
+
+#include "Host.h"
+
+/**
+ * Memory backed stand-in for the board's hardware UART.
+ */
+class HardwareSerial : public Host::MemoryStream
+{
+public:
+    void begin(unsigned long baud) { setBaud(baud); }
+    void end() {}
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef HOST_EEPROM_h
+#define HOST_EEPROM_h
+
+/**
+ * Host stand-in for the AVR EEPROM library.
+ * Backed by RAM, counts every byte read and every physical cell write.
+ */
+
+#include "Arduino.h"
+
+#define HOST_EEPROM_SIZE 1024
+
+class EEPROMClass
+{
+public:
+    uint8_t cells[HOST_EEPROM_SIZE];
+    // Physical writes per cell, to report wear
+    unsigned long cellWrites[HOST_EEPROM_SIZE];
+
+    EEPROMClass() { erase(); }
+
+    /**
+     * @brief Host only: return every cell to the erased state and clear the wear counts
+     */
+    void erase()
+    {
+        memset(cells, 0xFF, sizeof cells);
+        memset(cellWrites, 0, sizeof cellWrites);
+    }
+
+    /**
+     * @brief Host only: highest number of writes to a single cell
+     */
+    unsigned long maxCellWrites()
+    {
+        unsigned long most = 0;
+        for (int i = 0; i < HOST_EEPROM_SIZE; i++) if (cellWrites[i] > most) most = cellWrites[i];
+        return most;
+    }
+
+    uint8_t read(int idx)
+    {
+        Host::counters.eepromReads++;
+        return cells[idx];
+    }
+
+    void write(int idx, uint8_t val)
+    {
+        Host::counters.eepromWrites++;
+        cellWrites[idx]++;
+        cells[idx] = val;
+    }
+
+    void update(int idx, uint8_t val)
+    {
+        if (read(idx) != val) write(idx, val);
+    }
+
+    uint16_t length() { return HOST_EEPROM_SIZE; }
+
+    template<typename T> T &get(int idx, T &t)
+    {
+        uint8_t *ptr = (uint8_t *)&t;
+        for (size_t count = sizeof(T); count; --count, ++idx) *ptr++ = read(idx);
+        return t;
+    }
+
+    template<typename T> const T &put(int idx, const T &t)
+    {
+        const uint8_t *ptr = (const uint8_t *)&t;
+        for (size_t count = sizeof(T); count; --count, ++idx) update(idx, *ptr++);
+        return t;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,276 @@
+#ifndef HOST_FastLED_h
+#define HOST_FastLED_h
+
+/**
+ * Host stand-in for the subset of FastLED used by this library.
+ * Colour math follows FastLED's integer implementations so per-frame cost is representative.
+ * show() does not drive any pins, it scales the buffer into a sink and counts what would be sent.
+ */
+
+#include "Arduino.h"
+
+#pragma region Integer math
+
+inline uint8_t scale8(uint8_t i, uint8_t scale) { return (((uint16_t)i) * (1 + (uint16_t)scale)) >> 8; }
+inline uint8_t scale8_video(uint8_t i, uint8_t scale) { return (((int)i * (int)scale) >> 8) + ((i && scale) ? 1 : 0); }
+inline uint16_t scale16(uint16_t i, uint16_t scale) { return ((uint32_t)i * (1 + (uint32_t)scale)) / 65536; }
+inline uint8_t qadd8(uint8_t i, uint8_t j) { unsigned int t = i + j; return t > 255 ? 255 : t; }
+inline uint8_t qsub8(uint8_t i, uint8_t j) { int t = i - j; return t < 0 ? 0 : t; }
+inline uint8_t lerp8by8(uint8_t a, uint8_t b, uint8_t frac)
+{
+    return b > a ? a + scale8(b - a, frac) : a - scale8(a - b, frac);
+}
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB)
+{
+    uint16_t partial = (a << 8) | b;
+    partial += (b * amountOfB);
+    partial -= (a * amountOfB);
+    return partial >> 8;
+}
+
+#pragma endregion
+
+#pragma region Random
+
+extern uint16_t rand16seed;
+
+inline uint8_t random8()
+{
+    rand16seed = (rand16seed * 2053) + 13849;
+    return (uint8_t)(((uint8_t)(rand16seed & 0xFF)) + ((uint8_t)(rand16seed >> 8)));
+}
+inline uint8_t random8(uint8_t lim) { return (random8() * lim) >> 8; }
+inline uint16_t random16()
+{
+    rand16seed = (rand16seed * 2053) + 13849;
+    return rand16seed;
+}
+
+#pragma endregion
+
+#pragma region Pixel types
+
+struct CRGB;
+
+struct CHSV
+{
+    union
+    {
+        struct
+        {
+            union { uint8_t hue; uint8_t h; };
+            union { uint8_t saturation; uint8_t sat; uint8_t s; };
+            union { uint8_t value; uint8_t val; uint8_t v; };
+        };
+        uint8_t raw[3];
+    };
+
+    CHSV() {}
+    CHSV(uint8_t ih, uint8_t is, uint8_t iv): h(ih), s(is), v(iv) {}
+};
+
+void hsv2rgb_rainbow(const CHSV &hsv, CRGB &rgb);
+
+struct CRGB
+{
+    union
+    {
+        struct
+        {
+            union { uint8_t r; uint8_t red; };
+            union { uint8_t g; uint8_t green; };
+            union { uint8_t b; uint8_t blue; };
+        };
+        uint8_t raw[3];
+    };
+
+    CRGB() {}
+    CRGB(uint8_t ir, uint8_t ig, uint8_t ib): r(ir), g(ig), b(ib) {}
+    CRGB(const CRGB &rhs): r(rhs.r), g(rhs.g), b(rhs.b) {}
+    CRGB(const CHSV &rhs) { hsv2rgb_rainbow(rhs, *this); }
+
+    CRGB &operator=(const CRGB &rhs)
+    {
+        r = rhs.r; g = rhs.g; b = rhs.b;
+        Host::noteLEDWrite(this);
+        return *this;
+    }
+
+    CRGB &operator=(const CHSV &rhs)
+    {
+        hsv2rgb_rainbow(rhs, *this);
+        Host::noteLEDWrite(this);
+        return *this;
+    }
+
+    CRGB &setRGB(uint8_t nr, uint8_t ng, uint8_t nb)
+    {
+        r = nr; g = ng; b = nb;
+        Host::noteLEDWrite(this);
+        return *this;
+    }
+
+    CRGB &nscale8(uint8_t scale)
+    {
+        r = scale8(r, scale); g = scale8(g, scale); b = scale8(b, scale);
+        Host::noteLEDWrite(this);
+        return *this;
+    }
+
+    uint8_t &operator[](uint8_t x) { return raw[x]; }
+    const uint8_t &operator[](uint8_t x) const { return raw[x]; }
+
+    bool operator==(const CRGB &rhs) const { return r == rhs.r && g == rhs.g && b == rhs.b; }
+    bool operator!=(const CRGB &rhs) const { return !(*this == rhs); }
+
+    enum HTMLColorCode
+    {
+        Black = 0x000000,
+        White = 0xFFFFFF
+    };
+};
+
+#pragma endregion
+
+#pragma region Fill functions
+
+void fill_solid(struct CRGB *leds, int numToFill, const struct CRGB &color);
+void fill_solid(struct CRGB *leds, int numToFill, const struct CHSV &color);
+void fill_rainbow(struct CRGB *pFirstLED, int numToFill, uint8_t initialhue, uint8_t deltahue = 5);
+void nscale8(CRGB *leds, uint16_t num_leds, uint8_t scale);
+CRGB &nblend(CRGB &existing, const CRGB &overlay, uint8_t amountOfOverlay);
+
+#pragma endregion
+
+#pragma region Controllers
+
+// Temporal dithering modes, see CLEDController::setDither
+#define DISABLE_DITHER 0x00
+#define BINARY_DITHER 0x01
+
+enum EOrder
+{
+    RGB = 0012,
+    RBG = 0021,
+    GRB = 0102,
+    GBR = 0120,
+    BRG = 0201,
+    BGR = 0210
+};
+
+/**
+ * Base LED output. Each chipset instantiation registers itself in a global list, as in FastLED.
+ */
+class CLEDController
+{
+protected:
+    CRGB *m_Data;
+    int m_nLeds;
+    uint8_t m_DitherMode;
+    CLEDController *m_pNext;
+    static CLEDController *m_pHead;
+    static CLEDController *m_pTail;
+
+public:
+    CLEDController();
+    virtual ~CLEDController() {}
+
+    /**
+     * @brief Push the buffer out at the given brightness.
+     * With BINARY_DITHER, brightness is dithered across frames in the same way as FastLED.
+     */
+    virtual void showLeds(uint8_t brightness = 255);
+
+    CLEDController &setLeds(CRGB *data, int nLeds)
+    {
+        m_Data = data;
+        m_nLeds = nLeds;
+        return *this;
+    }
+
+    CLEDController &setDither(uint8_t ditherMode = BINARY_DITHER)
+    {
+        m_DitherMode = ditherMode;
+        return *this;
+    }
+    uint8_t getDither() { return m_DitherMode; }
+
+    CRGB *leds() { return m_Data; }
+    int size() { return m_nLeds; }
+    CLEDController *next() { return m_pNext; }
+    static CLEDController *head() { return m_pHead; }
+};
+
+template<uint8_t DATA_PIN, EOrder RGB_ORDER = RGB>
+class WS2812B : public CLEDController {};
+
+template<uint8_t DATA_PIN, EOrder RGB_ORDER = RGB>
+class WS2812 : public CLEDController {};
+
+template<uint8_t DATA_PIN, EOrder RGB_ORDER = RGB>
+class NEOPIXEL : public CLEDController {};
+
+class CFastLED
+{
+private:
+    uint8_t m_Scale;
+    uint16_t m_nRefreshRate;
+    uint32_t m_nMinMicros;
+    // Measured frame rate, as FastLED counts it in show()
+    uint16_t m_nFPS;
+    int m_nFPSFrames;
+    unsigned long m_nFPSStart;
+
+    void countFPS(int nFrames = 25);
+
+public:
+    CFastLED(): m_Scale(255), m_nRefreshRate(0), m_nMinMicros(0), m_nFPS(0), m_nFPSFrames(0), m_nFPSStart(0) {}
+
+    template<template<uint8_t DATA_PIN, EOrder RGB_ORDER> class CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    CLEDController &addLeds(CRGB *data, int nLeds)
+    {
+        static CHIPSET<DATA_PIN, RGB_ORDER> c;
+        return c.setLeds(data, nLeds);
+    }
+
+    void setBrightness(uint8_t scale) { m_Scale = scale; }
+    uint8_t getBrightness() { return m_Scale; }
+
+    /**
+     * @brief Records the frame rate cap. The stand-in never sleeps, so frames are not throttled.
+     */
+    void setMaxRefreshRate(uint16_t refresh, bool constrain = false);
+    uint16_t getMaxRefreshRate() { return m_nRefreshRate; }
+
+    /**
+     * @brief Frame rate of show() calls, measured every 25 calls as in FastLED
+     */
+    uint16_t getFPS() { return m_nFPS; }
+    /**
+     * @brief Host only: forget the measured frame rate
+     */
+    void resetFPS() { m_nFPS = 0; m_nFPSFrames = 0; m_nFPSStart = millis(); }
+
+    /**
+     * @brief Set the dithering mode of every controller, BINARY_DITHER by default as in FastLED
+     */
+    void setDither(uint8_t ditherMode = BINARY_DITHER);
+
+    /**
+     * @brief Show every controller. As in FastLED, dithering is turned off for the call while the measured frame rate
+     * is below 100 fps, so it only applies to outputs refreshed fast enough to hide it
+     */
+    void show() { show(m_Scale); }
+    void show(uint8_t scale);
+
+    int count();
+    CLEDController &operator[](int x);
+    int size() { return (*this)[0].size(); }
+    CRGB *leds() { return (*this)[0].leds(); }
+};
+
+extern CFastLED FastLED;
+
+#pragma endregion
+
+#endif
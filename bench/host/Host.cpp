@@ -0,0 +1,346 @@
+#include <stdio.h>
+
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "FastLED.h"
+#include "SPI.h"
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+CFastLED FastLED;
+SPIClass SPI;
+uint16_t rand16seed = 1337;
+
+namespace Host
+{
+    Counters counters;
+    bool ledTracking = false;
+    const void *ledTrackLow = NULL;
+    const void *ledTrackHigh = NULL;
+
+    unsigned long clockMicros = 0;
+    // Simulated wire time per LED shown
+    unsigned long showMicros = 0;
+
+    void resetCounters()
+    {
+        memset(&counters, 0, sizeof counters);
+    }
+
+    void reset()
+    {
+        resetCounters();
+        stopLEDTracking();
+        clockMicros = 0;
+        showMicros = 0;
+        rand16seed = 1337;
+        EEPROM.erase();
+        for (CLEDController *c = CLEDController::head(); c; c = c->next()) c->setLeds(NULL, 0).setDither(BINARY_DITHER);
+        FastLED.setBrightness(255);
+        FastLED.setMaxRefreshRate(0);
+        FastLED.resetFPS();
+        Serial.clear();
+        SPI.clear();
+    }
+
+    unsigned long now() { return clockMicros; }
+    void setMicros(unsigned long us) { clockMicros = us; }
+    void advanceMicros(unsigned long us) { clockMicros += us; }
+    void setShowMicrosPerLED(unsigned long us) { showMicros = us; }
+    unsigned long showMicrosPerLED() { return showMicros; }
+
+    void trackLEDWrites(const void *buffer, size_t bytes)
+    {
+        ledTrackLow = buffer;
+        ledTrackHigh = (const uint8_t *)buffer + bytes;
+        ledTracking = true;
+    }
+
+    void stopLEDTracking()
+    {
+        ledTracking = false;
+    }
+};
+
+#pragma region Arduino core
+
+unsigned long millis() { return Host::now() / 1000; }
+unsigned long micros() { return Host::now(); }
+void delay(unsigned long ms) { Host::advanceMicros(ms * 1000); }
+void delayMicroseconds(unsigned int us) { Host::advanceMicros(us); }
+
+long random(long max) { return max > 0 ? random16() % max : 0; }
+long random(long min, long max) { return max > min ? min + random(max - min) : min; }
+void randomSeed(unsigned long seed) { rand16seed = seed; }
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    if (base < 2) base = 10;
+    do {
+        char c = n % base;
+        n /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+    return write(str);
+}
+
+size_t Print::print(const char *str) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char n, int base) { return print((unsigned long)n, base); }
+size_t Print::print(int n, int base) { return print((long)n, base); }
+size_t Print::print(unsigned int n, int base) { return print((unsigned long)n, base); }
+size_t Print::print(long n, int base)
+{
+    if (base == 10 && n < 0) {
+        size_t t = print('-');
+        return t + printNumber(-n, 10);
+    }
+    return printNumber(n, base);
+}
+size_t Print::print(unsigned long n, int base) { return printNumber(n, base); }
+
+size_t Print::println() { return write("\r\n"); }
+size_t Print::println(const char *str) { size_t n = print(str); return n + println(); }
+size_t Print::println(char c) { size_t n = print(c); return n + println(); }
+size_t Print::println(unsigned char v, int base) { size_t n = print(v, base); return n + println(); }
+size_t Print::println(int v, int base) { size_t n = print(v, base); return n + println(); }
+size_t Print::println(unsigned int v, int base) { size_t n = print(v, base); return n + println(); }
+size_t Print::println(long v, int base) { size_t n = print(v, base); return n + println(); }
+size_t Print::println(unsigned long v, int base) { size_t n = print(v, base); return n + println(); }
+
+size_t Stream::readBytes(uint8_t *buffer, size_t length)
+{
+    size_t count = 0;
+    while (count < length && available() > 0) {
+        *buffer++ = read();
+        count++;
+    }
+    return count;
+}
+
+#pragma endregion
+
+#pragma region FastLED
+
+void hsv2rgb_rainbow(const CHSV &hsv, CRGB &rgb)
+{
+    Host::counters.hsvConversions++;
+    uint8_t hue = hsv.hue;
+    uint8_t sat = hsv.sat;
+    uint8_t val = hsv.val;
+
+    uint8_t offset = hue & 0x1F;
+    uint8_t offset8 = offset << 3;
+    uint8_t third = scale8(offset8, (256 / 3));
+
+    uint8_t r, g, b;
+
+    if (!(hue & 0x80)) {
+        if (!(hue & 0x40)) {
+            if (!(hue & 0x20)) {
+                r = 255 - third; g = third; b = 0;
+            } else {
+                r = 171; g = 85 + third; b = 0;
+            }
+        } else {
+            if (!(hue & 0x20)) {
+                uint8_t twothirds = scale8(offset8, ((256 * 2) / 3));
+                r = 171 - twothirds; g = 170 + third; b = 0;
+            } else {
+                r = 0; g = 255 - third; b = third;
+            }
+        }
+    } else {
+        if (!(hue & 0x40)) {
+            if (!(hue & 0x20)) {
+                uint8_t twothirds = scale8(offset8, ((256 * 2) / 3));
+                r = 0; g = 171 - twothirds; b = 85 + twothirds;
+            } else {
+                r = third; g = 0; b = 255 - third;
+            }
+        } else {
+            if (!(hue & 0x20)) {
+                r = 85 + third; g = 0; b = 171 - third;
+            } else {
+                r = 170 + third; g = 0; b = 85 - third;
+            }
+        }
+    }
+
+    if (sat != 255) {
+        if (sat == 0) {
+            r = 255; b = 255; g = 255;
+        } else {
+            uint8_t desat = 255 - sat;
+            desat = scale8_video(desat, desat);
+            uint8_t satscale = 255 - desat;
+            if (r) r = scale8(r, satscale) + 1;
+            if (g) g = scale8(g, satscale) + 1;
+            if (b) b = scale8(b, satscale) + 1;
+            r += desat; g += desat; b += desat;
+        }
+    }
+
+    if (val != 255) {
+        val = scale8_video(val, val);
+        if (val == 0) {
+            r = 0; g = 0; b = 0;
+        } else {
+            if (r) r = scale8(r, val) + 1;
+            if (g) g = scale8(g, val) + 1;
+            if (b) b = scale8(b, val) + 1;
+        }
+    }
+
+    rgb.r = r;
+    rgb.g = g;
+    rgb.b = b;
+}
+
+void fill_solid(struct CRGB *leds, int numToFill, const struct CRGB &color)
+{
+    for (int i = 0; i < numToFill; ++i) leds[i] = color;
+}
+
+void fill_solid(struct CRGB *leds, int numToFill, const struct CHSV &color)
+{
+    CRGB rgb;
+    hsv2rgb_rainbow(color, rgb);
+    fill_solid(leds, numToFill, rgb);
+}
+
+void fill_rainbow(struct CRGB *pFirstLED, int numToFill, uint8_t initialhue, uint8_t deltahue)
+{
+    CHSV hsv;
+    hsv.hue = initialhue;
+    hsv.val = 255;
+    hsv.sat = 240;
+    for (int i = 0; i < numToFill; ++i) {
+        pFirstLED[i] = hsv;
+        hsv.hue += deltahue;
+    }
+}
+
+void nscale8(CRGB *leds, uint16_t num_leds, uint8_t scale)
+{
+    for (uint16_t i = 0; i < num_leds; ++i) leds[i].nscale8(scale);
+}
+
+CRGB &nblend(CRGB &existing, const CRGB &overlay, uint8_t amountOfOverlay)
+{
+    if (amountOfOverlay == 0) return existing;
+    if (amountOfOverlay == 255) return existing = overlay;
+    return existing.setRGB(blend8(existing.r, overlay.r, amountOfOverlay),
+                           blend8(existing.g, overlay.g, amountOfOverlay),
+                           blend8(existing.b, overlay.b, amountOfOverlay));
+}
+
+CLEDController *CLEDController::m_pHead = NULL;
+CLEDController *CLEDController::m_pTail = NULL;
+
+CLEDController::CLEDController(): m_Data(NULL), m_nLeds(0), m_DitherMode(BINARY_DITHER), m_pNext(NULL)
+{
+    if (m_pHead == NULL) m_pHead = this;
+    if (m_pTail != NULL) m_pTail->m_pNext = this;
+    m_pTail = this;
+}
+
+// Sink for the scaled output so the push loop is not optimised away
+static volatile uint8_t outputSink;
+
+void CLEDController::showLeds(uint8_t brightness)
+{
+    // FastLED's binary dithering: an offset from a bit-reversed frame counter, added before scaling,
+    // alternating with its complement from one pixel to the next
+    static uint8_t frame = 0;
+    uint8_t d = 0, e = 0;
+    if (m_DitherMode == BINARY_DITHER && brightness < 255) {
+        frame = (frame + 1) & 0x07;
+        uint8_t q = 0;
+        if (frame & 0x01) q |= 0x80;
+        if (frame & 0x02) q |= 0x40;
+        if (frame & 0x04) q |= 0x20;
+        q += 0x10;
+        e = brightness ? 256 / brightness + 1 : 0;
+        d = scale8(q, e);
+        if (d) d--;
+        if (e) e--;
+    }
+
+    uint8_t acc = 0;
+    unsigned long levels = 0;
+    for (int i = 0; i < m_nLeds; i++) {
+        for (int c = 0; c < 3; c++) {
+            uint8_t v = scale8(qadd8(m_Data[i].raw[c], d), brightness);
+            acc ^= v;
+            levels += v;
+        }
+        d = e - d;
+    }
+    outputSink = acc;
+    Host::counters.ledsShown += m_nLeds;
+    Host::counters.levelsShown += levels;
+    Host::advanceMicros(m_nLeds * Host::showMicrosPerLED());
+}
+
+void CFastLED::setDither(uint8_t ditherMode)
+{
+    for (CLEDController *c = CLEDController::head(); c; c = c->next()) c->setDither(ditherMode);
+}
+
+void CFastLED::setMaxRefreshRate(uint16_t refresh, bool constrain)
+{
+    if (constrain && m_nRefreshRate > 0 && refresh > m_nRefreshRate) return;
+    m_nRefreshRate = refresh;
+    m_nMinMicros = refresh > 0 ? 1000000 / refresh : 0;
+}
+
+void CFastLED::show(uint8_t scale)
+{
+    Host::counters.shows++;
+    for (CLEDController *c = CLEDController::head(); c; c = c->next()) {
+        if (!c->leds()) continue;
+        uint8_t d = c->getDither();
+        if (m_nFPS < 100) c->setDither(DISABLE_DITHER);
+        c->showLeds(scale);
+        c->setDither(d);
+    }
+    countFPS();
+}
+
+void CFastLED::countFPS(int nFrames)
+{
+    if (m_nFPSFrames++ >= nFrames) {
+        unsigned long elapsed = millis() - m_nFPSStart;
+        if (elapsed == 0) elapsed = 1;
+        m_nFPS = (m_nFPSFrames * 1000) / elapsed;
+        m_nFPSFrames = 0;
+        m_nFPSStart = millis();
+    }
+}
+
+int CFastLED::count()
+{
+    int x = 0;
+    for (CLEDController *c = CLEDController::head(); c; c = c->next()) x++;
+    return x;
+}
+
+CLEDController &CFastLED::operator[](int x)
+{
+    CLEDController *c = CLEDController::head();
+    while (x-- && c) c = c->next();
+    return *c;
+}
+
+#pragma endregion
@@ -0,0 +1,132 @@
+#ifndef HOST_Host_h
+#define HOST_Host_h
+
+/**
+ * Host-only helpers used by the stand-in Arduino, EEPROM, FastLED and SPI headers.
+ * Provides the simulated clock, the instrumentation counters and an in-memory Stream.
+ */
+
+#include <string>
+
+namespace Host
+{
+    /**
+     * Counters incremented by the stand-in libraries.
+     */
+    struct Counters
+    {
+        // EEPROM bytes read / physically written (update() only counts when the value changes)
+        unsigned long eepromReads;
+        unsigned long eepromWrites;
+        // Number of FastLED.show() calls and LEDs pushed out by them
+        unsigned long shows;
+        unsigned long ledsShown;
+        // Sum of the channel values sent by show(), after brightness and dithering
+        unsigned long long levelsShown;
+        // Bytes written into the tracked LED buffer through CRGB assignment
+        unsigned long ledBytesWritten;
+        // HSV to RGB conversions, including those made by fill_rainbow and CHSV assignment
+        unsigned long hsvConversions;
+    };
+
+    extern Counters counters;
+
+    /**
+     * @brief Zero all counters
+     */
+    void resetCounters();
+
+    /**
+     * @brief Reset all host state: counters, clock, EEPROM contents (0xFF), FastLED controllers and SPI output
+     */
+    void reset();
+
+    #pragma region Simulated clock
+
+    unsigned long now();
+    void setMicros(unsigned long us);
+    void advanceMicros(unsigned long us);
+
+    /**
+     * @brief Simulate the time taken to send each LED when an output is shown (e.g. 30us for WS2812B), 0 by default
+     */
+    void setShowMicrosPerLED(unsigned long us);
+    unsigned long showMicrosPerLED();
+
+    #pragma endregion
+
+    #pragma region LED write tracking
+
+    extern bool ledTracking;
+    extern const void *ledTrackLow;
+    extern const void *ledTrackHigh;
+
+    /**
+     * @brief Count bytes assigned into the given buffer until stopLEDTracking is called
+     */
+    void trackLEDWrites(const void *buffer, size_t bytes);
+    void stopLEDTracking();
+
+    /**
+     * @brief Called by the CRGB stand-in on every assignment
+     */
+    inline void noteLEDWrite(const void *p)
+    {
+        if (ledTracking && p >= ledTrackLow && p < ledTrackHigh)
+            counters.ledBytesWritten += 3;
+    }
+
+    #pragma endregion
+
+    /**
+     * In-memory Stream.
+     * Bytes queued with feed() are returned by read(), everything printed is captured in output().
+     */
+    class MemoryStream : public ::Stream
+    {
+    private:
+        std::string _input;
+        size_t _inputPos;
+        std::string _output;
+        unsigned long _baud;
+        unsigned long _writeCalls;
+        unsigned long _writeMicros;
+    public:
+        MemoryStream(): _inputPos(0), _baud(0), _writeCalls(0), _writeMicros(0) {}
+
+        /**
+         * @brief Advance the simulated clock by the time written bytes take on the wire (10 bits per byte), 0 to not
+         */
+        void setBaud(unsigned long baud) { _baud = baud; }
+        unsigned long getBaud() { return _baud; }
+        /**
+         * @brief Advance the simulated clock by a fixed time for every write call,
+         * e.g. a serial bridge (such as Bluetooth) sending each write as its own packet
+         */
+        void setWriteMicros(unsigned long us) { _writeMicros = us; }
+
+        void feed(const char *str) { _input.append(str); }
+        void feed(const uint8_t *data, size_t len) { _input.append((const char *)data, len); }
+
+        const std::string &output() { return _output; }
+        unsigned long writeCalls() { return _writeCalls; }
+        void clear() { _input.clear(); _inputPos = 0; _output.clear(); _writeCalls = 0; }
+
+        int available() override { return (int)(_input.size() - _inputPos); }
+        int read() override { return available() ? (uint8_t)_input[_inputPos++] : -1; }
+        int peek() override { return available() ? (uint8_t)_input[_inputPos] : -1; }
+
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t *buffer, size_t size) override
+        {
+            _writeCalls++;
+            _output.append((const char *)buffer, size);
+            unsigned long us = _writeMicros + (_baud ? size * 10000000UL / _baud : 0);
+            if (us) advanceMicros(us);
+            return size;
+        }
+        using Print::write;
+    };
+};
+
+#endif
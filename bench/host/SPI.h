@@ -0,0 +1,66 @@
+#ifndef HOST_SPI_h
+#define HOST_SPI_h
+
+/**
+ * Host stand-in for the Arduino SPI library.
+ * Keeps every byte transferred, and advances the simulated clock by the time they take at the transaction's clock
+ * when the transaction ends.
+ */
+
+#include "Arduino.h"
+
+#ifndef MSBFIRST
+#define MSBFIRST 1
+#endif
+#define SPI_MODE0 0x00
+
+class SPISettings
+{
+public:
+    uint32_t clock;
+
+    SPISettings(): clock(4000000) {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode): clock(clock) {}
+};
+
+class SPIClass
+{
+private:
+    std::string _output;
+    uint32_t _clock;
+    unsigned long _pending;
+
+public:
+    SPIClass(): _clock(4000000), _pending(0) {}
+
+    void begin() {}
+    void end() {}
+
+    void beginTransaction(SPISettings settings)
+    {
+        _clock = settings.clock;
+        _pending = 0;
+    }
+    void endTransaction()
+    {
+        if (_clock) Host::advanceMicros((unsigned long)((unsigned long long)_pending * 8 * 1000000 / _clock));
+        _pending = 0;
+    }
+
+    uint8_t transfer(uint8_t data)
+    {
+        _output += (char)data;
+        _pending++;
+        return 0;
+    }
+
+    /**
+     * @brief Host only: every byte transferred since the last clear
+     */
+    const std::string &output() { return _output; }
+    void clear() { _output.clear(); _pending = 0; }
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef HOST_SerialCommands_h
+#define HOST_SerialCommands_h
+
+/**
+ * Host stand-in for ppedro74's SerialCommands library (v2).
+ * Line buffering, strtok_r tokenising and the linear command lookup follow the original.
+ */
+
+#include "Arduino.h"
+
+typedef enum ternary
+{
+    SERIAL_COMMANDS_SUCCESS = 0,
+    SERIAL_COMMANDS_ERROR_NO_SERIAL,
+    SERIAL_COMMANDS_ERROR_BUFFER_FULL
+} SERIAL_COMMANDS_ERRORS;
+
+class SerialCommands;
+
+class SerialCommand
+{
+public:
+    SerialCommand(const char *cmd, void (*func)(SerialCommands *), bool one_k = false):
+        command(cmd), function(func), next(NULL), one_key(one_k) {}
+
+    const char *command;
+    void (*function)(SerialCommands *);
+    SerialCommand *next;
+    bool one_key;
+};
+
+class SerialCommands
+{
+public:
+    SerialCommands(Stream *serial, char *buffer, int16_t buffer_len, const char *term = "\r\n", const char *delim = " "):
+        serial_(serial), buffer_(buffer), buffer_len_(buffer ? buffer_len - 1 : 0), term_(term), delim_(delim),
+        default_handler_(NULL), buffer_pos_(0), last_token_(NULL), term_pos_(0),
+        commands_head_(NULL), commands_tail_(NULL), commands_count_(0)
+    {
+        ClearBuffer();
+    }
+
+    void AddCommand(SerialCommand *command)
+    {
+        command->next = NULL;
+        if (commands_head_ == NULL) {
+            commands_head_ = commands_tail_ = command;
+        } else {
+            commands_tail_->next = command;
+            commands_tail_ = command;
+        }
+        commands_count_++;
+    }
+
+    SERIAL_COMMANDS_ERRORS ReadSerial()
+    {
+        if (serial_ == NULL) return SERIAL_COMMANDS_ERROR_NO_SERIAL;
+
+        while (serial_->available() > 0) {
+            int ch = serial_->read();
+            if (ch <= 0) continue;
+
+            if (buffer_pos_ < buffer_len_) {
+                buffer_[buffer_pos_++] = ch;
+            } else {
+                ClearBuffer();
+                return SERIAL_COMMANDS_ERROR_BUFFER_FULL;
+            }
+
+            if (term_[term_pos_] != ch) {
+                term_pos_ = 0;
+                continue;
+            }
+
+            if (term_[++term_pos_] == 0) {
+                buffer_[buffer_pos_ - strlen(term_)] = '\0';
+
+                char *command = strtok_r(buffer_, delim_, &last_token_);
+                if (command) {
+                    bool matched = false;
+                    for (SerialCommand *cmd = commands_head_; cmd != NULL; cmd = cmd->next) {
+                        if (strncmp(command, cmd->command, strlen(cmd->command) + 1) == 0) {
+                            cmd->function(this);
+                            matched = true;
+                            break;
+                        }
+                    }
+                    if (!matched && default_handler_ != NULL) {
+                        (*default_handler_)(this, command);
+                    }
+                }
+                ClearBuffer();
+            }
+        }
+        return SERIAL_COMMANDS_SUCCESS;
+    }
+
+    Stream *GetSerial() { return serial_; }
+    void AttachSerial(Stream *serial) { serial_ = serial; }
+    void DetachSerial() { serial_ = NULL; }
+
+    void SetDefaultHandler(void (*function)(SerialCommands *, const char *)) { default_handler_ = function; }
+
+    void ClearBuffer()
+    {
+        if (buffer_) buffer_[0] = '\0';
+        buffer_pos_ = 0;
+        term_pos_ = 0;
+    }
+
+    char *Next() { return strtok_r(NULL, delim_, &last_token_); }
+
+    void *context;
+
+private:
+    Stream *serial_;
+    char *buffer_;
+    int16_t buffer_len_;
+    const char *term_;
+    const char *delim_;
+    void (*default_handler_)(SerialCommands *, const char *);
+    int16_t buffer_pos_;
+    char *last_token_;
+    int8_t term_pos_;
+    SerialCommand *commands_head_;
+    SerialCommand *commands_tail_;
+    uint8_t commands_count_;
+};
+
+#endif
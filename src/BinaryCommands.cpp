@@ -0,0 +1,562 @@
+#include "BinaryCommands.h"
+#include "LEDStripController.h"
+
+namespace LEDStripController {
+    /**
+     * Anonymous namespace containing the binary opcode handlers.
+     * Each mirrors the text command of the same name in commandFuncs.
+     */
+    namespace {
+        namespace binaryFuncs
+        {
+            /**
+             * Reply with a single byte value
+             */
+            uint8_t replyByte(BinaryCommands *sender, uint8_t val)
+            {
+                sender->setReply(&val, 1);
+                return Status::ok;
+            }
+
+            /**
+             * Get the SerialController the frames are read by
+             */
+            SerialController* commands(BinaryCommands *sender)
+            {
+                // Only SerialController creates binary command handlers
+                return (SerialController*)sender->getParent();
+            }
+
+            /**
+             * Get the segment selected with the segment opcode
+             */
+            Controller* selected(BinaryCommands *sender)
+            {
+                return commands(sender)->getSelected();
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get effect id
+             * [id] - Set effect
+             */
+            uint8_t effect(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = selected(sender);
+                if (len == 0) return replyByte(sender, c->getEffect());
+                if (len != 1) return Status::badLength;
+                if (c->findEffect(payload[0]) < 0) return Status::outOfRange;
+                c->setEffect(payload[0]);
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Flip the enabled state
+             * [state] - Set the enabled state
+             * Replies with the new state
+             */
+            uint8_t toggle(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = selected(sender);
+                if (len > 1) return Status::badLength;
+                c->setEnabled(len ? payload[0] != 0 : !c->getEnabled());
+                return replyByte(sender, c->getEnabled());
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get current color
+             * [index] - Get color with index
+             * [r, g, b] - Set current color
+             * [r, g, b, index] - Set color with index
+             */
+            uint8_t color(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = selected(sender);
+                CRGB col;
+
+                switch (len)
+                {
+                case 0:
+                    col = c->getColor();
+                    sender->setReply(col.raw, sizeof col.raw);
+                    return Status::ok;
+
+                case 1:
+                    if (payload[0] >= maxColors) return Status::outOfRange;
+                    col = c->getColor(payload[0]);
+                    sender->setReply(col.raw, sizeof col.raw);
+                    return Status::ok;
+
+                case 3:
+                    c->setColor(payload[0], payload[1], payload[2]);
+                    return Status::ok;
+
+                case 4:
+                    if (payload[3] >= maxColors) return Status::outOfRange;
+                    c->setColor(payload[0], payload[1], payload[2], payload[3]);
+                    return Status::ok;
+
+                default:
+                    return Status::badLength;
+                }
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get minimum color index
+             * [index] - Set minimum color index
+             */
+            uint8_t minColor(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = selected(sender);
+                if (len == 0) return replyByte(sender, c->getMinimumColorIndex());
+                if (len != 1) return Status::badLength;
+                if (payload[0] >= maxColors) return Status::outOfRange;
+                c->setMinimumColorIndex(payload[0]);
+                c->setColorIndexOffset(0);
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get maximum color index
+             * [index] - Set maximum color index
+             */
+            uint8_t maxColor(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = selected(sender);
+                if (len == 0) return replyByte(sender, c->getMaximumColorIndex());
+                if (len != 1) return Status::badLength;
+                if (payload[0] >= maxColors) return Status::outOfRange;
+                c->setMaximumColorIndex(payload[0]);
+                c->setColorIndexOffset(0);
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get brightness
+             * [value] - Set brightness
+             */
+            uint8_t brightness(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = selected(sender);
+                if (len == 0) return replyByte(sender, c->getBrightness());
+                if (len != 1) return Status::badLength;
+                c->setBrightness(payload[0]);
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get fps
+             * [value(1-255)] - Set fps
+             */
+            uint8_t fps(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = commands(sender)->getStrip();
+                if (len == 0) return replyByte(sender, c->getFPS());
+                if (len != 1) return Status::badLength;
+                if (payload[0] < 1) return Status::outOfRange;
+                c->setFPS(payload[0]);
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get speed
+             * [percent(1-255)] - Set speed
+             */
+            uint8_t speed(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = selected(sender);
+                if (len == 0) return replyByte(sender, c->getSpeed());
+                if (len != 1) return Status::badLength;
+                if (payload[0] < 1) return Status::outOfRange;
+                c->setSpeed(payload[0]);
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get the transition duration
+             * [ms (2 bytes)] - Set the transition duration, high byte first
+             */
+            uint8_t transition(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = selected(sender);
+                if (len == 0) {
+                    uint8_t reply[2] = { (uint8_t)(c->getTransitionTime() >> 8), (uint8_t)c->getTransitionTime() };
+                    sender->setReply(reply, sizeof reply);
+                    return Status::ok;
+                }
+                if (len != 2) return Status::badLength;
+                c->setTransitionTime((payload[0] << 8) | payload[1]);
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get the power budget and the current estimate
+             * [mA (2 bytes)] - Set the power budget of the selected strip, high byte first, 0 for no limit
+             */
+            uint8_t power(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = commands(sender)->getStrip();
+                if (len == 0) {
+                    uint8_t reply[4] = {
+                        (uint8_t)(c->getPowerBudget() >> 8), (uint8_t)c->getPowerBudget(),
+                        (uint8_t)(c->getPowerDraw() >> 8), (uint8_t)c->getPowerDraw()
+                    };
+                    sender->setReply(reply, sizeof reply);
+                    return Status::ok;
+                }
+                if (len != 2) return Status::badLength;
+                c->setPowerBudget((payload[0] << 8) | payload[1]);
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get whether the selected strip is dithered
+             * [state] - Set whether the selected strip is dithered
+             * Replies with the new state
+             */
+            uint8_t dither(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = commands(sender)->getStrip();
+                if (len > 1) return Status::badLength;
+                if (len) c->setDither(payload[0] != 0);
+                return replyByte(sender, c->getDither());
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get the selected segment and its range
+             * [index] - Select the segment following opcodes apply to
+             * [index, start (2 bytes), length (2 bytes)] - Move or resize a segment, high bytes first
+             */
+            uint8_t segment(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                SerialController *c = commands(sender);
+                uint8_t reply[5];
+
+                switch (len)
+                {
+                case 0:
+                    reply[0] = c->getSelectedSegment();
+                    reply[1] = c->getStrip()->getSegmentStart(reply[0]) >> 8;
+                    reply[2] = c->getStrip()->getSegmentStart(reply[0]);
+                    reply[3] = c->getSelected()->getNumLEDs() >> 8;
+                    reply[4] = c->getSelected()->getNumLEDs();
+                    sender->setReply(reply, sizeof reply);
+                    return Status::ok;
+
+                case 1:
+                    return c->selectSegment(payload[0]) ? Status::ok : Status::outOfRange;
+
+                case 5:
+                    if (!c->getStrip()->setSegmentRange(payload[0], (payload[1] << 8) | payload[2], (payload[3] << 8) | payload[4])) return Status::outOfRange;
+                    return Status::ok;
+
+                default:
+                    return Status::badLength;
+                }
+            }
+
+            /**
+             * Opcode handler
+             * [] - Write changed settings to EEPROM
+             */
+            uint8_t save(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                if (len != 0) return Status::badLength;
+                if (commands(sender)->getStripManager()) commands(sender)->getStripManager()->save();
+                else sender->getParent()->save();
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get the selected strip
+             * [index] - Select the strip following opcodes apply to, see StripManager
+             */
+            uint8_t strip(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                SerialController *c = commands(sender);
+                if (len == 0) return replyByte(sender, c->getSelectedStrip());
+                if (len != 1) return Status::badLength;
+                return c->selectStrip(payload[0]) ? Status::ok : Status::outOfRange;
+            }
+
+#if LEDCON_STATS
+            /**
+             * Put a 16 bit value in a reply, high byte first
+             */
+            uint8_t *put16(uint8_t *out, uint16_t val)
+            {
+                out[0] = val >> 8;
+                out[1] = val;
+                return out + 2;
+            }
+
+            /**
+             * Put the min, avg and max of a stage in a reply
+             */
+            uint8_t *putStage(uint8_t *out, StageTiming &stage)
+            {
+                out = put16(out, stage.min);
+                out = put16(out, stage.average());
+                return put16(out, stage.max);
+            }
+
+            /**
+             * Opcode handler
+             * [] - Get the frame timings of the selected segment and reset them:
+             *      frames (4 bytes), late, dropped, EEPROM writes, then min, avg and max of parse, show and the current effect's render
+             * [effect id] - Get the render count (4 bytes), min, avg and max of one effect, without resetting
+             */
+            uint8_t stats(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                Controller *c = selected(sender);
+                FrameStats &stats = c->getStats();
+                uint8_t reply[28];
+                uint8_t *out = reply;
+
+                if (len == 1) {
+                    int idx = c->findEffect(payload[0]);
+                    if (idx < 0) return Status::outOfRange;
+                    StageTiming &render = stats.getRender(idx);
+                    out = put16(out, render.count >> 16);
+                    out = put16(out, render.count);
+                    out = putStage(out, render);
+                    sender->setReply(reply, out - reply);
+                    return Status::ok;
+                }
+                if (len != 0) return Status::badLength;
+
+                FrameStats &parse = sender->getParent()->getStats();
+                out = put16(out, stats.frames >> 16);
+                out = put16(out, stats.frames);
+                out = put16(out, stats.late);
+                out = put16(out, stats.dropped);
+                out = put16(out, stats.eepromWrites);
+                out = putStage(out, parse.parse);
+                out = putStage(out, stats.show);
+                out = putStage(out, stats.getRender(c->findEffect(c->getEffect())));
+                sender->setReply(reply, out - reply);
+
+                parse.parse = StageTiming();
+                stats.reset();
+                return Status::ok;
+            }
+#else
+            // Not built, answered as an unknown opcode
+            const BinaryCommands::Handler stats = NULL;
+#endif
+
+            /**
+             * Opcode handler
+             * [] - Replies with the URL of the command list
+             */
+            uint8_t help(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                static const char url[] = "https://github.com/randomman552/Led-Strip-Controller";
+                sender->setReply((const uint8_t*)url, sizeof url - 1);
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Go back to text commands, after this reply
+             */
+            uint8_t text(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                if (len != 0) return Status::badLength;
+                sender->setActive(false);
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Read raw pixel frames after the reply, see PixelStream. Refused while the LEDs are an IndexedFrame
+             */
+            uint8_t stream(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                if (len != 0) return Status::badLength;
+                if (commands(sender)->getFrame()) return Status::outOfRange;
+                // Only SerialController creates binary command handlers
+                commands(sender)->setStreamMode(true);
+                sender->stopReading();
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Start a batch, following frames are applied together by commit
+             */
+            uint8_t begin(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                if (len != 0) return Status::badLength;
+                if (sender->getParent()->inBatch()) return Status::batchRejected;
+                commands(sender)->beginCommandBatch();
+                return Status::ok;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Apply the open batch, or undo it if any frame in it failed
+             */
+            uint8_t commit(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                if (len != 0) return Status::badLength;
+                if (!sender->getParent()->inBatch()) return Status::batchRejected;
+                return commands(sender)->commitCommandBatch() ? Status::ok : Status::batchRejected;
+            }
+
+            /**
+             * Opcode handler
+             * [] - Undo the open batch
+             */
+            uint8_t abort(BinaryCommands *sender, const uint8_t *payload, uint8_t len)
+            {
+                if (len != 0) return Status::badLength;
+                commands(sender)->abortCommandBatch();
+                return Status::ok;
+            }
+
+            // Handlers indexed by opcode
+            const BinaryCommands::Handler handlers[Opcodes::count] = {
+                NULL, effect, toggle, color, minColor, maxColor, brightness, fps, save, help, text, stream, begin, commit, abort, speed, segment, strip, transition, stats, power, dither
+            };
+        }; // namespace binaryFuncs
+    }; // namespace
+
+    #pragma region Constructors
+
+    BinaryCommands::BinaryCommands(Controller *parent, Stream *serial)
+    {
+        _parent = parent;
+        _serial = serial;
+        _active = false;
+        _stopRead = false;
+        _pos = 0;
+        _lastByte = 0;
+        _replyLen = 0;
+    }
+
+    #pragma endregion
+
+    #pragma region Setters
+
+    void BinaryCommands::setReply(const uint8_t *data, uint8_t len) {
+        if (len > maxReply) len = maxReply;
+        memcpy(_reply + 4, data, len);
+        _replyLen = len;
+    }
+
+    void BinaryCommands::stopReading() {
+        _stopRead = true;
+    }
+
+    void BinaryCommands::setActive(bool val) {
+        _active = val;
+        _pos = 0;
+    }
+
+    #pragma endregion
+
+    #pragma region Getters
+
+    bool BinaryCommands::isActive() {
+        return _active;
+    }
+
+    Controller* BinaryCommands::getParent() {
+        return _parent;
+    }
+
+    Stream* BinaryCommands::getSerial() {
+        return _serial;
+    }
+
+    #pragma endregion
+
+    #pragma region Frame handling
+
+    void BinaryCommands::read()
+    {
+        // Stop as soon as the text or stream opcode is handled, the rest of the stream is for another reader
+        _stopRead = false;
+        while (_active && !_stopRead && _serial->available() > 0) {
+            uint8_t b = _serial->read();
+
+            // Drop a partial frame the sender has given up on
+            if (_pos && millis() - _lastByte > frameTimeout) _pos = 0;
+            _lastByte = millis();
+
+            if (_pos == 0) {
+                if (b == sync) _pos = 1;
+                continue;
+            }
+
+            _frame[_pos - 1] = b;
+            _pos++;
+
+            // Length byte received, reject frames that do not fit the buffer
+            if (_pos == 3 && _frame[1] > maxPayload) {
+                _replyLen = 0;
+                binaryFuncs::commands(this)->failCommandBatch();
+                sendReply(_frame[0], Status::badLength);
+                _pos = 0;
+                continue;
+            }
+
+            // Sync, opcode, length, payload and CRC received
+            if (_pos > 3 && _pos == _frame[1] + 4) {
+                dispatch();
+                _pos = 0;
+            }
+        }
+    }
+
+    void BinaryCommands::dispatch()
+    {
+        uint8_t opcode = _frame[0];
+        uint8_t len = _frame[1];
+        _replyLen = 0;
+
+        if (crc8(_frame, len + 2) != _frame[len + 2]) {
+            binaryFuncs::commands(this)->failCommandBatch();
+            sendReply(opcode, Status::badCRC);
+            return;
+        }
+        if (opcode >= Opcodes::count || binaryFuncs::handlers[opcode] == NULL) {
+            binaryFuncs::commands(this)->failCommandBatch();
+            sendReply(opcode, Status::unknownOpcode);
+            return;
+        }
+
+        uint8_t status = binaryFuncs::handlers[opcode](this, _frame + 2, len);
+
+        // Inside a batch a failure rejects the whole batch, and plain acknowledgements are left to the commit
+        if (status != Status::ok) binaryFuncs::commands(this)->failCommandBatch();
+        else if (_parent->inBatch() && _replyLen == 0) return;
+        sendReply(opcode, status);
+    }
+
+    void BinaryCommands::sendReply(uint8_t opcode, uint8_t status)
+    {
+        // Data was placed after the header by setReply
+        _reply[0] = sync;
+        _reply[1] = opcode;
+        _reply[2] = _replyLen + 1;
+        _reply[3] = status;
+        _reply[_replyLen + 4] = crc8(_reply + 1, _replyLen + 3);
+        _serial->write(_reply, _replyLen + 5);
+    }
+
+    #pragma endregion
+};
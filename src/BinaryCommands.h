@@ -0,0 +1,148 @@
+#ifndef LEDCON_BinaryCommands_h
+#define LEDCON_BinaryCommands_h
+
+#include <Arduino.h>
+
+namespace LEDStripController
+{
+    class Controller;
+
+    /**
+     * Namespace containing the binary protocol opcodes.
+     * Each opcode matches a text command, see the README for payloads.
+     */
+    namespace Opcodes
+    {
+        const uint8_t effect = 0x01;
+        const uint8_t toggle = 0x02;
+        const uint8_t color = 0x03;
+        const uint8_t minColor = 0x04;
+        const uint8_t maxColor = 0x05;
+        const uint8_t brightness = 0x06;
+        const uint8_t fps = 0x07;
+        const uint8_t save = 0x08;
+        const uint8_t help = 0x09;
+        // Leave binary mode and go back to text commands
+        const uint8_t text = 0x0A;
+        // Switch to raw pixel frames, see PixelStream
+        const uint8_t stream = 0x0B;
+        // Batches, see Controller::beginBatch
+        const uint8_t begin = 0x0C;
+        const uint8_t commit = 0x0D;
+        const uint8_t abort = 0x0E;
+        const uint8_t speed = 0x0F;
+        // Select the segment following opcodes apply to, see Controller::addSegment
+        const uint8_t segment = 0x10;
+        // Select the strip following opcodes apply to, see StripManager
+        const uint8_t strip = 0x11;
+        const uint8_t transition = 0x12;
+        // Only answered when built with LEDCON_STATS, see FrameStats
+        const uint8_t stats = 0x13;
+        // Current budget of the selected strip, see Controller::setPowerBudget
+        const uint8_t power = 0x14;
+        // Temporal dithering of the selected strip, see Controller::setDither
+        const uint8_t dither = 0x15;
+        const uint8_t count = 0x16;
+    };
+
+    /**
+     * Namespace containing the status codes sent back in binary replies
+     */
+    namespace Status
+    {
+        const uint8_t ok = 0;
+        const uint8_t unknownOpcode = 1;
+        const uint8_t badLength = 2;
+        const uint8_t outOfRange = 3;
+        const uint8_t badCRC = 4;
+        const uint8_t batchRejected = 5;
+    };
+
+    /**
+     * Parser for the framed binary command protocol.
+     *
+     * Request: [sync] [opcode] [length] [payload (length bytes)] [CRC-8 of opcode, length and payload]
+     * Reply:   [sync] [opcode] [length] [status] [data (length - 1 bytes)] [CRC-8 of opcode, length, status and data]
+     *
+     * Inside a batch only failed frames and frames returning data are answered, until the commit.
+     * Bytes are consumed as they arrive, so reading never blocks.
+     * A partial frame is dropped if the next byte takes longer than frameTimeout to arrive.
+     */
+    class BinaryCommands
+    {
+    public:
+        static const uint8_t sync = 0xA5;
+        static const uint8_t maxPayload = 16;
+        static const uint8_t maxReply = 64;
+        // Milliseconds allowed between the bytes of a frame
+        static const unsigned long frameTimeout = 50;
+
+        /**
+         * Opcode handler.
+         * Returns a value from the Status namespace, data for the reply is given with setReply.
+         */
+        typedef uint8_t (*Handler)(BinaryCommands *sender, const uint8_t *payload, uint8_t len);
+
+    private:
+        Controller *_parent;
+        Stream *_serial;
+        bool _active;
+        // Set by a handler to leave the rest of the stream for another reader
+        bool _stopRead;
+
+        // Frame being received, without the sync byte: opcode, length, payload, CRC
+        uint8_t _frame[maxPayload + 3];
+        // Bytes received since the sync byte, 0 while waiting for one
+        uint8_t _pos;
+        unsigned long _lastByte;
+
+        uint8_t _reply[maxReply + 5];
+        uint8_t _replyLen;
+
+        /**
+         * @brief Run the handler for the received frame and send the reply
+         */
+        void dispatch();
+        /**
+         * @brief Send a reply frame holding the status and any data given with setReply
+         */
+        void sendReply(uint8_t opcode, uint8_t status);
+
+    public:
+        /**
+         * @brief Construct a new binary command parser, inactive until setActive is called
+         * @param parent Controller commands are applied to
+         * @param serial Stream frames are received through and replies sent to
+         */
+        BinaryCommands(Controller *parent, Stream *serial);
+
+        /**
+         * @brief Process all available bytes, running the handler of each complete frame
+         */
+        void read();
+
+        /**
+         * @brief Set the data sent with the reply to the current frame
+         * @param data Reply data
+         * @param len Number of bytes, at most maxReply
+         */
+        void setReply(const uint8_t *data, uint8_t len);
+
+        /**
+         * @brief Stop reading after the current frame, leaving the following bytes in the stream
+         */
+        void stopReading();
+
+        /**
+         * @brief Set whether the stream is read as binary frames
+         * @param val Desired value
+         */
+        void setActive(bool val);
+        bool isActive();
+
+        Controller *getParent();
+        Stream *getSerial();
+    };
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef LEDCON_ColorCorrection_h
+#define LEDCON_ColorCorrection_h
+
+#include <Arduino.h>
+
+namespace LEDStripController
+{
+    /**
+     * Gamma and white balance correction, see Controller::setCorrection.
+     * One 256 byte lookup table per channel, stored in flash (PROGMEM).
+     * Build one with colorCorrection, the tables are generated by the compiler.
+     */
+    struct ColorCorrection
+    {
+        const uint8_t *red;
+        const uint8_t *green;
+        const uint8_t *blue;
+    };
+
+    /**
+     * Compile-time generation of the correction tables.
+     * Only constexpr arithmetic is used, so the tables are constants and no floating point code is linked.
+     */
+    namespace Correction
+    {
+        constexpr double ln2 = 0.69314718055994531;
+
+        // ln(x) for x in [0.5, 1], as 2 * atanh((x - 1) / (x + 1))
+        constexpr double lnSeries(double y, double y2, double term, int k) {
+            return k > 41 ? 0 : term / k + lnSeries(y, y2, term * y2, k + 2);
+        }
+        constexpr double ln(double x) {
+            return x < 0.5 ? ln(x * 2) - ln2 : 2 * lnSeries((x - 1) / (x + 1), ((x - 1) / (x + 1)) * ((x - 1) / (x + 1)), (x - 1) / (x + 1), 1);
+        }
+
+        // e^x for x <= 0, halving x until the Taylor series converges quickly
+        constexpr double expSeries(double x, double term, int k) {
+            return k > 16 ? 0 : term + expSeries(x, term * x / k, k + 1);
+        }
+        constexpr double square(double x) {
+            return x * x;
+        }
+        constexpr double exp(double x) {
+            return x < -0.5 ? square(exp(x / 2)) : expSeries(x, 1, 1);
+        }
+
+        /**
+         * @brief Table entry: max * (i / 255) ^ (gamma / 100), rounded
+         */
+        constexpr uint8_t curve(uint8_t i, uint16_t gamma, uint8_t max) {
+            return i == 0 ? 0 : (uint8_t)(max * exp(ln(i / 255.0) * gamma / 100.0) + 0.5);
+        }
+
+        template<uint8_t... I>
+        struct Indices {};
+
+        // Indices<0, 1, ..., N - 1>
+        template<unsigned N, uint8_t... I>
+        struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+        template<uint8_t... I>
+        struct MakeIndices<0, I...>
+        {
+            typedef Indices<I...> type;
+        };
+
+        template<uint16_t Gamma, uint8_t Max, typename Idx = typename MakeIndices<256>::type>
+        struct Table;
+
+        /**
+         * Lookup table for one channel, each instantiation is stored in flash once
+         */
+        template<uint16_t Gamma, uint8_t Max, uint8_t... I>
+        struct Table<Gamma, Max, Indices<I...> >
+        {
+            static const uint8_t values[256];
+        };
+
+        template<uint16_t Gamma, uint8_t Max, uint8_t... I>
+        const uint8_t Table<Gamma, Max, Indices<I...> >::values[256] PROGMEM = { curve(I, Gamma, Max)... };
+    };
+
+    /**
+     * @brief Build a correction from a gamma and the white balance, e.g. colorCorrection<220, 255, 176, 240>() for
+     * gamma 2.2 on a strip whose green and blue are brighter than its red
+     * @tparam Gamma Gamma in hundredths, 100 for none
+     * @tparam Red Output for full red, scaling the channel to balance white
+     * @tparam Green Output for full green
+     * @tparam Blue Output for full blue
+     */
+    template<uint16_t Gamma, uint8_t Red = 255, uint8_t Green = 255, uint8_t Blue = 255>
+    constexpr ColorCorrection colorCorrection() {
+        return ColorCorrection{
+            Correction::Table<Gamma, Red>::values,
+            Correction::Table<Gamma, Green>::values,
+            Correction::Table<Gamma, Blue>::values
+        };
+    }
+};
+
+#endif
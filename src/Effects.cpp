@@ -2,129 +2,268 @@
 
 // Base lighting functions
 namespace LEDStripController::Effects {
-    // Iterator value for lighting functions
-    int i = 0;
-    // Boolean to control iteration direction for lighting functions
-    bool reverse = false;
+    namespace {
+        /**
+         * Convert a HSV color to RGB, reusing the previous conversion while the color is unchanged
+         */
+        CRGB toRGB(Controller &C, const CHSV &col) {
+            EffectState &S = C.getState();
+            if (col.h != S.hsv.h || col.s != S.hsv.s || col.v != S.hsv.v) {
+                hsv2rgb_rainbow(col, S.rgb);
+                S.hsv = col;
+            }
+            return S.rgb;
+        }
+
+        /**
+         * Fill count LEDs from first with a color, through the palette when drawing to an IndexedFrame.
+         * Applies the Controller's color correction and keeps its power estimate up to date.
+         */
+        void fillSpan(Controller &C, int first, int count, const CRGB &col) {
+            CRGB out = C.correct(col);
+            C.noteFill(first, count, out);
+            IndexedFrame *frame = C.getFrame();
+            if (frame) frame->fill(first, count, out);
+            else fill_solid(C.getLEDs() + first, count, out);
+        }
+
+        // Ends reported by bounce
+        const uint8_t reachedEnd = 0x01;
+        const uint8_t reachedStart = 0x02;
+
+        /**
+         * Move S.i by the frame's steps, between 0 and max, turning around (flipping S.reverse) at each end.
+         * Returns which ends were reached, as reachedEnd/reachedStart flags.
+         */
+        uint8_t bounce(Controller &C, int max) {
+            EffectState &S = C.getState();
+            uint8_t reached = 0;
+            if (max <= 0) return reached;
+
+            int steps = C.getSteps();
+            while (steps > 0) {
+                int room = S.reverse ? S.i : max - S.i;
+                int move = steps < room ? steps : room;
+                S.i += S.reverse ? -move : move;
+                steps -= move;
+
+                if (S.i == (S.reverse ? 0 : max)) {
+                    reached |= S.reverse ? reachedStart : reachedEnd;
+                    S.reverse = !S.reverse;
+                }
+            }
+            return reached;
+        }
+
+        /**
+         * Hue step, in 8.8 fixed point, spreading one whole rainbow over numLEDs pixels.
+         * An 8 bit step (255 / numLEDs) is 0 past 255 LEDs and coarse past about 128.
+         */
+        uint16_t rainbowStep(int numLEDs) {
+            return numLEDs > 0 ? (uint16_t)(0x10000UL / numLEDs) : 0;
+        }
+
+        /**
+         * Fill count pixels with a rainbow from hue, adding hueStep per pixel (both 8.8 fixed point).
+         * On strips longer than 256 LEDs neighbouring pixels share a hue, so each hue is only converted (and corrected) once.
+         */
+        void fillRainbow(Controller &C, CRGB *leds, uint16_t count, uint16_t hue, uint16_t hueStep) {
+            if (count == 0) return;
+            // Same saturation as FastLED's fill_rainbow
+            CHSV hsv(hue >> 8, 240, 255);
+            CRGB rgb = C.correct(hsv);
+            for (uint16_t i = 0; i < count; i++) {
+                uint8_t h = hue >> 8;
+                if (h != hsv.h) {
+                    hsv.h = h;
+                    hsv2rgb_rainbow(hsv, rgb);
+                    rgb = C.correct(rgb);
+                }
+                leds[i] = rgb;
+                hue += hueStep;
+            }
+        }
+
+        /**
+         * Draw the pixels [from, to), lit with the color or a rainbow (hueStep per pixel from pixel 0), or cleared
+         */
+        void paint(Controller &C, int from, int to, bool lit, const CRGB &col, bool rainbow, uint16_t hueStep) {
+            if (to <= from) return;
+            if (!lit) fillSpan(C, from, to - from, CRGB(0, 0, 0));
+            else if (rainbow) fillRainbow(C, C.getLEDs() + from, to - from, (uint16_t)((uint32_t)hueStep * from), hueStep);
+            else fillSpan(C, from, to - from, col);
+        }
+
+        /**
+         * Change the lit span [s1, e1) into [s2, e2), only drawing the pixels at the ends that differ.
+         * Spans that do not overlap are cleared and drawn in full.
+         */
+        void moveSpan(Controller &C, int s1, int e1, int s2, int e2, const CRGB &col, bool rainbow = false, uint16_t hueStep = 0) {
+            if (s1 == s2 && e1 == e2) return;
+            C.markDirty();
+
+            if (e1 <= s1 || e2 <= s2 || e1 <= s2 || e2 <= s1) {
+                paint(C, s1, e1, false, col, rainbow, hueStep);
+                paint(C, s2, e2, true, col, rainbow, hueStep);
+                return;
+            }
+            if (s2 < s1) paint(C, s2, s1, true, col, rainbow, hueStep);
+            else paint(C, s1, s2, false, col, rainbow, hueStep);
+            if (e2 > e1) paint(C, e1, e2, true, col, rainbow, hueStep);
+            else paint(C, e2, e1, false, col, rainbow, hueStep);
+        }
+
+        /**
+         * Lit span of fillEmpty at position i, filling from the start then emptying from the start
+         */
+        void wipeSpan(int numLEDs, int i, int &start, int &end) {
+            start = i > numLEDs ? i - numLEDs : 0;
+            end = i > numLEDs ? numLEDs : i;
+        }
+
+        /**
+         * Lit spans of fillEmptyMiddle at position i, one in each half of the strip.
+         * The strip fills from both ends, then empties towards the middle.
+         */
+        void middleSpans(int numLEDs, int i, int *start, int *end) {
+            int mid = numLEDs / 2;
+            if (i > mid) {
+                start[0] = i - mid; end[0] = mid;
+                start[1] = mid; end[1] = numLEDs - (i - mid);
+            } else {
+                start[0] = 0; end[0] = i;
+                start[1] = numLEDs - i; end[1] = numLEDs;
+            }
+        }
+
+        /**
+         * Bring the strip from the fillEmpty frame at S.drawn to the one at S.i
+         */
+        void drawWipe(Controller &C, const CRGB &col, bool rainbow, uint16_t hueStep) {
+            EffectState &S = C.getState();
+            int s2, e2;
+            wipeSpan(C.getNumLEDs(), S.i, s2, e2);
+
+            // Redraw everything when requested or when the color changes
+            if (C.needsRedraw() || (!rainbow && col != S.last)) {
+                clear(C);
+                paint(C, s2, e2, true, col, rainbow, hueStep);
+                C.markDirty();
+            } else {
+                int s1, e1;
+                wipeSpan(C.getNumLEDs(), S.drawn, s1, e1);
+                moveSpan(C, s1, e1, s2, e2, col, rainbow, hueStep);
+            }
+            S.drawn = S.i;
+            S.last = col;
+        }
+    };
 
     void clear(Controller &C) {
         CRGB col(0, 0, 0);
-        fill_solid(C.getLEDs(), C.getNumLEDs(), col);
+        fillSpan(C, 0, C.getNumLEDs(), col);
     }
 
 
     void fill(Controller &C, CRGB col) {
-        i = clamp(i, 0, 255);
-        fill_solid(C.getLEDs(), C.getNumLEDs(), col);
+        EffectState &S = C.getState();
+        S.i = clamp(S.i, 0, 255);
+
+        // Only redraw when the color has changed
+        if (C.needsRedraw() || col != S.last) {
+            fillSpan(C, 0, C.getNumLEDs(), col);
+            S.last = col;
+            C.markDirty();
+        }
         
-        // Advance color after set duration (255 frames)
-        if (i == 255) {
-            i = 0;
+        // Advance color after set duration (255 steps), keeping any steps past it
+        S.i += C.getSteps();
+        if (S.i >= 255) {
+            S.i %= 255;
             C.advanceColor();
-            Random::randomise();
+            Random::randomise(C);
         }
-        i++;
     }
 
     void fill(Controller &C, CHSV col) {
-        CRGB rgbCol;
-        hsv2rgb_rainbow(col, rgbCol);
-        fill(C, rgbCol);
+        fill(C, toRGB(C, col));
     }
 
 
     void fade(Controller &C, CRGB col) {
+        EffectState &S = C.getState();
         // Ensure i is within range
-        i = clamp(i, 0, 255);
+        S.i = clamp(S.i, 0, 255);
 
-        col.r = col.r * ((float)i / 255);
-        col.g = col.g * ((float)i / 255);
-        col.b = col.b * ((float)i / 255);
+        // Fixed point scale by i/256, no floating point on AVR
+        col.nscale8(S.i);
 
-        fill_solid(C.getLEDs(), C.getNumLEDs(), col);
+        // Dim colors repeat over several frames, only redraw when the scaled color changes
+        if (C.needsRedraw() || col != S.last) {
+            fillSpan(C, 0, C.getNumLEDs(), col);
+            S.last = col;
+            C.markDirty();
+        }
         
-        // Iterate i depending on reverse boolean
-        if (reverse) i--; else i++;
-
-        // If i has reached a limit, invert reverse and clamp i
+        // Iterate i depending on reverse boolean, turning around at the limits
         // Advance to the next color if we have faded out
-        if (i == 255) { 
-            reverse = !reverse;
-        } else if (i == 0) {
-            reverse = !reverse;
+        if (bounce(C, 255) & reachedStart) {
             C.advanceColor();
-            Random::randomise();
+            Random::randomise(C);
         }
     }
 
     void fade(Controller &C, CHSV col) {
-        CRGB rgbCol;
-        hsv2rgb_rainbow(col, rgbCol);
-        fade(C, rgbCol);
+        fade(C, toRGB(C, col));
     }
 
 
     void fillEmpty(Controller &C, CRGB col) {
-        i = clamp(i, 0, C.getNumLEDs() * 2);
-        clear(C);
-
-        int start;
-        int length;
-        //Calculate appropriate start and length depending on whether we are past the max led number
-        if (i > C.getNumLEDs())
-        {
-            start = i - C.getNumLEDs();
-            length = C.getNumLEDs() - (i - C.getNumLEDs());
-        } else {
-            start = 0;
-            length = i;
-        }
-        fill_solid(C.getLEDs() + start, length, col);
+        EffectState &S = C.getState();
+        S.i = clamp(S.i, 0, C.getNumLEDs() * 2);
 
-        if (reverse) i--; else i++;
-        if (i == C.getNumLEDs() * 2 || i == 0) {
-            reverse = !reverse;
+        // Only the pixels at the ends of the lit span change between frames
+        drawWipe(C, col, false, 0);
+
+        if (bounce(C, C.getNumLEDs() * 2)) {
             // Advance color when reaching end of strip
             C.advanceColor();
-            Random::randomise();
+            Random::randomise(C);
         }
     }
 
     void fillEmpty(Controller &C, CHSV col) {
-        CRGB rgbCol;
-        hsv2rgb_rainbow(col, rgbCol);
-        fillEmpty(C, rgbCol);
+        fillEmpty(C, toRGB(C, col));
     }
 
 
     void fillEmptyMiddle(Controller &C, CRGB col) {
-        i = clamp(i, 0, C.getNumLEDs());
-        clear(C);
-
-        int mid = C.getNumLEDs() / 2;
-
-        //Fill the led strip appropriately depending on our iteration status
-        if (i > mid) {
-            //Filling from edges
-            fill_solid(C.getLEDs() + i - mid, C.getNumLEDs() - (i - mid) * 2, col);
+        EffectState &S = C.getState();
+        S.i = clamp(S.i, 0, C.getNumLEDs());
+
+        // Each half of the strip holds one lit span, only the pixels at its ends change between frames
+        int start[2], end[2];
+        middleSpans(C.getNumLEDs(), S.i, start, end);
+        if (C.needsRedraw() || col != S.last) {
+            clear(C);
+            for (int h = 0; h < 2; h++) paint(C, start[h], end[h], true, col, false, 0);
+            C.markDirty();
         } else {
-            //Emptying to middle
-            fill_solid(C.getLEDs(), i, col);
-            fill_solid(C.getLEDs() + (C.getNumLEDs() - i), i, col);
+            int drawnStart[2], drawnEnd[2];
+            middleSpans(C.getNumLEDs(), S.drawn, drawnStart, drawnEnd);
+            for (int h = 0; h < 2; h++) moveSpan(C, drawnStart[h], drawnEnd[h], start[h], end[h], col);
         }
+        S.drawn = S.i;
+        S.last = col;
         
-        if (reverse) i--; else i++;
-        if (i == C.getNumLEDs() || i == 0) { 
-            reverse = !reverse;
+        if (bounce(C, C.getNumLEDs())) {
             C.advanceColor();
-            Random::randomise();
+            Random::randomise(C);
         }
     }
 
     void fillEmptyMiddle(Controller &C, CHSV col) {
-        CRGB rgbCol;
-        hsv2rgb_rainbow(col, rgbCol);
-        fillEmptyMiddle(C, rgbCol);
+        fillEmptyMiddle(C, toRGB(C, col));
     }
 };
 
@@ -135,28 +274,43 @@ namespace LEDStripController::Effects::Color {
     }
 
     void alternateFill(Controller &C) {
+        EffectState &S = C.getState();
         int start = C.getMinimumColorIndex();
         int numCols = C.getMaximumColorIndex() + 1 - start;
-        CRGB *leds = C.getLEDs();
+        IndexedFrame *frame = C.getFrame();
+        // Drawn as palette indices when drawing to an IndexedFrame, the active colors fit in its palette
+        uint8_t *pixels = frame ? frame->getIndices() : (uint8_t*)C.getLEDs();
+        size_t pixelSize = frame ? 1 : sizeof(CRGB);
         int numLEDs = C.getNumLEDs();
         int offset = C.getColorIndexOffset();
 
-        for (int i = 0; i < numLEDs; i++)
-        {
-            // Math to work out color alternations
-            // Modulo operators keep valus within numCols range
-            // Offset gives the appearance of moving the colors down the led strip 
-            // (it is incremented when C.advanceColor is called)
-            // Start is the offset to the start of active colors in colors array
-            leds[i] = C.getColor(((i % numCols) + offset) % numCols + start);
+        // The pattern only changes with the colors or offset, which request a redraw
+        if (C.needsRedraw() && numLEDs > 0) {
+            // Resolve the active colors once, rotated by the offset
+            // (it is incremented when C.advanceColor is called, giving the appearance of moving the colors down the strip)
+            int period = numCols < numLEDs ? numCols : numLEDs;
+            if (frame) frame->clearPalette();
+            for (int i = 0; i < period; i++) {
+                CRGB col = C.correct(C.getColor((i + offset) % numCols + start));
+                if (frame) pixels[i] = frame->findColor(col);
+                else C.getLEDs()[i] = col;
+            }
+
+            // Repeat the pattern by copying what has been drawn so far, doubling it each time
+            for (int len = numCols; len < numLEDs; ) {
+                int count = len < numLEDs - len ? len : numLEDs - len;
+                memcpy((void*)(pixels + len * pixelSize), (const void*)pixels, count * pixelSize);
+                len += count;
+            }
+            C.markDirty();
         }
 
-        // Advance color after set duration (255 frames)
-        if (i == 255) {
-            i = 0;
+        // Advance color after set duration (255 steps), keeping any steps past it
+        S.i += C.getSteps();
+        if (S.i >= 255) {
+            S.i %= 255;
             C.advanceColor();
         }
-        i++;
     }
 
     void fade(Controller &C) {
@@ -174,72 +328,95 @@ namespace LEDStripController::Effects::Color {
 
 // Rainbow lighting functions
 namespace LEDStripController::Effects::Rainbow {
-    int startHue = 0;
-    
     void fill(Controller &C) {
-        fill_rainbow(C.getLEDs(), C.getNumLEDs(), startHue, 255 / C.getNumLEDs());
+        // Static gradient, only drawn when a redraw is requested
+        if (!C.needsRedraw()) return;
+        fillRainbow(C, C.getLEDs(), C.getNumLEDs(), C.getState().hue * 256U, rainbowStep(C.getNumLEDs()));
+        C.markDirty();
     }
 
     void fillEmpty(Controller &C) {
-        i = clamp(i, 0, C.getNumLEDs() * 2);
-        clear(C);
-
-        int start;
-        int length;
-        int hChange = 255 / C.getNumLEDs();
-
-        //Calculate appropriate start and length depending on whether we are past the max led number
-        if (i > C.getNumLEDs())
-        {
-            start = i - C.getNumLEDs();
-            length = C.getNumLEDs() - (i - C.getNumLEDs());
-        } else {
-            start = 0;
-            length = i;
-        }
-        fill_rainbow(C.getLEDs() + start, length, hChange * start, hChange);
+        EffectState &S = C.getState();
+        S.i = clamp(S.i, 0, C.getNumLEDs() * 2);
+
+        // Each pixel's hue only depends on its position, so only the pixels at the ends of the lit span change
+        drawWipe(C, CRGB(0, 0, 0), true, rainbowStep(C.getNumLEDs()));
 
-        if (reverse) i--; else i++;
-        if (i == C.getNumLEDs() * 2 || i == 0) reverse = !reverse;
+        bounce(C, C.getNumLEDs() * 2);
     }
 
     void cycle(Controller &C) {
-        CHSV hueCol(startHue, 255, 255);
-        fill_solid(C.getLEDs(), C.getNumLEDs(), hueCol);
+        EffectState &S = C.getState();
+        CHSV hueCol(S.hue, 255, 255);
+        fill_solid(C.getLEDs(), C.getNumLEDs(), C.correct(hueCol));
 
-        //Iterate the hue value once for each function call.
+        //Iterate the hue value once for each step.
         //Don't need to use REVERSE_HANDLER here as the hue value will just overflow back round to 0.
-        startHue++;
+        S.hue += C.getSteps();
     }
 
     void spinCycle(Controller &C) {
+        EffectState &S = C.getState();
         //Functions in a similar way to the normal cycle function
-        fill_rainbow(C.getLEDs(), C.getNumLEDs(), startHue, 255 / C.getNumLEDs());
-        startHue++;
+        fillRainbow(C, C.getLEDs(), C.getNumLEDs(), S.hue * 256U, rainbowStep(C.getNumLEDs()));
+        S.hue += C.getSteps();
     }
 };
 
 // Random lighting functions
 namespace LEDStripController::Effects::Random {
-    CHSV color = CHSV(random8(), 255, 255);
-
-    void randomise() {
-        color = CHSV(random8(), 255, 255);
+    void randomise(Controller &C) {
+        C.getState().color = CHSV(random8(), 255, 255);
     }
 
     void fill(Controller &C) {
-        Effects::fill(C, color);
+        Effects::fill(C, C.getState().color);
     }
 
     void fade(Controller &C) {
-        Effects::fade(C, color);
+        Effects::fade(C, C.getState().color);
     }
 
     void fillEmpty(Controller &C) {
-        Effects::fillEmpty(C, color);
+        Effects::fillEmpty(C, C.getState().color);
     }
 
     void fillEmptyMiddle(Controller &C) {
-        Effects::fillEmptyMiddle(C, color);
+        Effects::fillEmptyMiddle(C, C.getState().color);
     }
+};
+
+// Built-in effect names and table
+namespace LEDStripController::Effects {
+    namespace Names {
+        const char colorFill[] PROGMEM = "Single color fill";
+        const char colorAlternateFill[] PROGMEM = "Alternate fill";
+        const char colorFade[] PROGMEM = "Single color fade";
+        const char colorFillEmpty[] PROGMEM = "Single color wipe";
+        const char colorFillEmptyMiddle[] PROGMEM = "Single color wipe (center)";
+        const char rainbowFill[] PROGMEM = "Rainbow fill";
+        const char rainbowFillEmpty[] PROGMEM = "Rainbow wipe";
+        const char rainbowCycle[] PROGMEM = "Rainbow shift";
+        const char rainbowSpinCycle[] PROGMEM = "Rainbow cycle";
+        const char randomFill[] PROGMEM = "Random color fill";
+        const char randomFade[] PROGMEM = "Random color fade";
+        const char randomFillEmpty[] PROGMEM = "Random color wipe";
+        const char randomFillEmptyMiddle[] PROGMEM = "Random color wipe (center)";
+    };
+
+    const Effect all[13] = {
+        colorFill,
+        colorAlternateFill,
+        colorFade,
+        colorFillEmpty,
+        colorFillEmptyMiddle,
+        rainbowFill,
+        rainbowFillEmpty,
+        rainbowCycle,
+        rainbowSpinCycle,
+        randomFill,
+        randomFade,
+        randomFillEmpty,
+        randomFillEmptyMiddle
+    };
 };
\ No newline at end of file
@@ -10,6 +10,8 @@ namespace LEDStripController {
     /**
      * Namespace containing lighting functions
      * ALL functions match the following function signature: void func(Controller &C)
+     * Animation state is kept in the Controller's EffectState (see Controller::getState),
+     * so each Controller animates independently.
      */
     namespace Effects
     {
@@ -21,21 +23,24 @@ namespace LEDStripController {
         void clear(Controller &C);
 
         /**
-         * @brief Basic function to fill the LED strip with a given color
+         * @brief Basic function to fill the LED strip with a given color.
+         * Only redraws (and marks the frame dirty) when the color changes or a redraw is requested.
          * @param C The Controller instance
          * @param col Color to fill with
          */
         void fill(Controller &C, CRGB col);
 
         /**
-         * @brief Variant of fill that takes a HSV color
+         * @brief Variant of fill that takes a HSV color.
+         * The HSV variants only convert the color when it changes, the result is kept in the EffectState.
          * @param C The Controller instance
          * @param col Color to fill with
          */
         void fill (Controller &C, CHSV col);
 
         /**
-         * @brief Basic function to fade a color in and out
+         * @brief Basic function to fade a color in and out.
+         * Only redraws (and marks the frame dirty) when the scaled color changes.
          * @param C The Controller instance
          * @param col Color to fill with
          */
@@ -50,6 +55,7 @@ namespace LEDStripController {
 
         /**
          * @brief Basic lighting function that fills the LED strip from one end and empties it to the other.
+         * Only the pixels that change since the previous frame are drawn.
          * @param C The Controller instance
          * @param col Color to fill with
          */
@@ -63,7 +69,8 @@ namespace LEDStripController {
         void fillEmpty(Controller &C, CHSV col);
 
         /**
-         * @brief Basic lighting function that fills the LED strip towards the middle and then empties it
+         * @brief Basic lighting function that fills the LED strip towards the middle and then empties it.
+         * Only the pixels that change since the previous frame are drawn.
          * @param C The Controller instance
          * @param col Color to fill with
          */
@@ -129,13 +136,13 @@ namespace LEDStripController {
 
             /**
              * Fill the LED strip with a hue.
-             * Advance hue by 1 each frame, showly shifting through all colors
+             * Advance hue by 1 each step, showly shifting through all colors
              */
             void cycle(Controller &C);
 
             /**
              * Fill LED strip with rainbow gradient
-             * Rotate rainbow gradient by 1 each frame
+             * Rotate rainbow gradient by 1 each step
              */
             void spinCycle(Controller &C);
         } // namespace Rainbow
@@ -146,9 +153,10 @@ namespace LEDStripController {
         namespace Random
         {
             /**
-             * Randomise current Random color
+             * Randomise the Controller's current Random color.
+             * Used as the init function of the Random effects.
              */
-            void randomise();
+            void randomise(Controller &C);
 
             /**
              * Fill led strip with random color
@@ -170,6 +178,53 @@ namespace LEDStripController {
              */
             void fillEmptyMiddle(Controller &C);
         } // namespace Random
+
+        /**
+         * Names of the built-in effects, stored in flash
+         */
+        namespace Names
+        {
+            extern const char colorFill[];
+            extern const char colorAlternateFill[];
+            extern const char colorFade[];
+            extern const char colorFillEmpty[];
+            extern const char colorFillEmptyMiddle[];
+            extern const char rainbowFill[];
+            extern const char rainbowFillEmpty[];
+            extern const char rainbowCycle[];
+            extern const char rainbowSpinCycle[];
+            extern const char randomFill[];
+            extern const char randomFade[];
+            extern const char randomFillEmpty[];
+            extern const char randomFillEmptyMiddle[];
+        } // namespace Names
+
+        #pragma region Effect descriptors
+
+        /**
+         * Descriptors of the built-in effects, for building effect tables.
+         * Ids match the numbering in the README.
+         */
+        constexpr Effect colorFill(0, Names::colorFill, Color::fill, NULL, NULL, EffectFlags::tracksChanges | EffectFlags::indexed | EffectFlags::tracksPower);
+        constexpr Effect colorAlternateFill(1, Names::colorAlternateFill, Color::alternateFill, NULL, NULL, EffectFlags::tracksChanges | EffectFlags::indexed);
+        constexpr Effect colorFade(2, Names::colorFade, Color::fade, NULL, NULL, EffectFlags::tracksChanges | EffectFlags::indexed | EffectFlags::tracksPower);
+        constexpr Effect colorFillEmpty(3, Names::colorFillEmpty, Color::fillEmpty, NULL, NULL, EffectFlags::tracksChanges | EffectFlags::indexed | EffectFlags::tracksPower);
+        constexpr Effect colorFillEmptyMiddle(4, Names::colorFillEmptyMiddle, Color::fillEmptyMiddle, NULL, NULL, EffectFlags::tracksChanges | EffectFlags::indexed | EffectFlags::tracksPower);
+        constexpr Effect rainbowFill(5, Names::rainbowFill, Rainbow::fill, NULL, NULL, EffectFlags::tracksChanges);
+        constexpr Effect rainbowFillEmpty(6, Names::rainbowFillEmpty, Rainbow::fillEmpty, NULL, NULL, EffectFlags::tracksChanges);
+        constexpr Effect rainbowCycle(7, Names::rainbowCycle, Rainbow::cycle);
+        constexpr Effect rainbowSpinCycle(8, Names::rainbowSpinCycle, Rainbow::spinCycle);
+        constexpr Effect randomFill(9, Names::randomFill, Random::fill, Random::randomise, NULL, EffectFlags::tracksChanges | EffectFlags::indexed | EffectFlags::tracksPower);
+        constexpr Effect randomFade(10, Names::randomFade, Random::fade, Random::randomise, NULL, EffectFlags::tracksChanges | EffectFlags::indexed | EffectFlags::tracksPower);
+        constexpr Effect randomFillEmpty(11, Names::randomFillEmpty, Random::fillEmpty, Random::randomise, NULL, EffectFlags::tracksChanges | EffectFlags::indexed | EffectFlags::tracksPower);
+        constexpr Effect randomFillEmptyMiddle(12, Names::randomFillEmptyMiddle, Random::fillEmptyMiddle, Random::randomise, NULL, EffectFlags::tracksChanges | EffectFlags::indexed | EffectFlags::tracksPower);
+
+        /**
+         * Table of all built-in effects, used by the default Controller constructor
+         */
+        extern const Effect all[13];
+
+        #pragma endregion
         
     }; // namespace Effects
 };
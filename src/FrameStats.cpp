@@ -0,0 +1,27 @@
+#include "FrameStats.h"
+
+#if LEDCON_STATS
+
+namespace LEDStripController {
+    void StageTiming::add(unsigned long us) {
+        uint16_t val = us > 0xFFFF ? 0xFFFF : us;
+        if (count == 0 || val < min) min = val;
+        if (val > max) max = val;
+        total += val;
+        count++;
+    }
+
+    uint16_t StageTiming::average() {
+        return count ? total / count : 0;
+    }
+
+    void FrameStats::reset() {
+        memset((void*)this, 0, sizeof *this);
+    }
+
+    StageTiming& FrameStats::getRender(uint8_t effectIdx) {
+        return render[effectIdx < maxEffects ? effectIdx : maxEffects - 1];
+    }
+};
+
+#endif
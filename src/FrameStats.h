@@ -0,0 +1,77 @@
+#ifndef LEDCON_FrameStats_h
+#define LEDCON_FrameStats_h
+
+#include <Arduino.h>
+
+/**
+ * Frame timing instrumentation, off by default.
+ * Build with -DLEDCON_STATS=1 (e.g. build_flags in PlatformIO) to time each stage of a frame
+ * and enable the "stats" command. When off none of the counters or timing calls are compiled in.
+ */
+#ifndef LEDCON_STATS
+#define LEDCON_STATS 0
+#endif
+
+#if LEDCON_STATS
+
+namespace LEDStripController
+{
+    /**
+     * Timing of one stage of a frame, in microseconds
+     */
+    struct StageTiming
+    {
+        unsigned long count;
+        unsigned long total;
+        uint16_t min;
+        uint16_t max;
+
+        /**
+         * @brief Record one run of the stage
+         * @param us Time taken, saturated at 65535
+         */
+        void add(unsigned long us);
+        /**
+         * @brief Get the average time taken
+         * @return uint16_t Microseconds, 0 if the stage has not run
+         */
+        uint16_t average();
+    };
+
+    /**
+     * Counters kept by a Controller since they were last reset, see Controller::getStats
+     */
+    struct FrameStats
+    {
+        // Effects timed separately, effects further down the table share the last entry
+        static const uint8_t maxEffects = 16;
+
+        // Reading and running commands, only timed when bytes were waiting
+        StageTiming parse;
+        // Drawing a frame, per index in the effect table
+        StageTiming render[maxEffects];
+        // Sending the frame to the LEDs
+        StageTiming show;
+
+        unsigned long frames;
+        // Frames drawn a quarter of a period or more after they were due, and whole frame periods skipped
+        uint16_t late;
+        uint16_t dropped;
+        // Settings records written to EEPROM
+        uint16_t eepromWrites;
+
+        /**
+         * @brief Zero every counter
+         */
+        void reset();
+        /**
+         * @brief Get the render timing of an effect
+         * @param effectIdx Index in the effect table
+         */
+        StageTiming& getRender(uint8_t effectIdx);
+    };
+};
+
+#endif
+
+#endif
@@ -0,0 +1,82 @@
+#include "IndexedFrame.h"
+
+namespace LEDStripController {
+    IndexedFrame::IndexedFrame(uint8_t *indices, int length, PixelWriter writer) {
+        _indices = indices;
+        _length = indices ? length : 0;
+        _writer = writer;
+        memset(_error, 0, sizeof _error);
+        clearPalette();
+    }
+
+    uint8_t IndexedFrame::findColor(const CRGB &col) {
+        for (uint8_t i = 0; i < _numColors; i++) {
+            if (_palette[i] == col) return i;
+        }
+        if (_numColors < paletteSize) _numColors++;
+        _palette[_numColors - 1] = col;
+        return _numColors - 1;
+    }
+
+    void IndexedFrame::fill(int first, int count, uint8_t idx) {
+        if (first < 0) { count += first; first = 0; }
+        if (count > _length - first) count = _length - first;
+        if (count <= 0) return;
+        memset(_indices + first, idx, count);
+    }
+
+    void IndexedFrame::fill(int first, int count, const CRGB &col) {
+        if (first <= 0 && first + count >= _length) clearPalette();
+        fill(first, count, findColor(col));
+    }
+
+    void IndexedFrame::clearPalette() {
+        _numColors = 0;
+    }
+
+    void IndexedFrame::show(uint8_t brightness, bool dither) {
+        if (!_writer || _length <= 0) return;
+
+        // Scale the palette once, rather than every pixel
+        CRGB palette[paletteSize];
+        for (uint8_t i = 0; i < _numColors; i++) {
+            if (!dither) {
+                palette[i] = _palette[i];
+                palette[i].nscale8(brightness);
+                continue;
+            }
+            // Same scale as scale8, adding the fraction left over from the previous frame
+            for (uint8_t c = 0; c < 3; c++) {
+                uint16_t scaled = _palette[i][c] * (brightness + 1) + _error[i][c];
+                palette[i][c] = scaled >> 8;
+                _error[i][c] = scaled;
+            }
+        }
+        // Indices past the palette (left from before it was cleared) are sent as black
+        for (uint8_t i = _numColors; i < paletteSize; i++) palette[i] = CRGB(0, 0, 0);
+
+        CRGB chunk[chunkSize];
+        for (int first = 0; first < _length; first += chunkSize) {
+            uint8_t count = _length - first < chunkSize ? _length - first : chunkSize;
+            const uint8_t *idx = _indices + first;
+            for (uint8_t i = 0; i < count; i++) chunk[i] = palette[idx[i] % paletteSize];
+            _writer(chunk, count, first, _length);
+        }
+    }
+
+    uint8_t *IndexedFrame::getIndices() {
+        return _indices;
+    }
+
+    int IndexedFrame::getLength() {
+        return _length;
+    }
+
+    CRGB IndexedFrame::getColor(uint8_t idx) {
+        return idx < _numColors ? _palette[idx] : CRGB(0, 0, 0);
+    }
+
+    uint8_t IndexedFrame::getNumColors() {
+        return _numColors;
+    }
+};
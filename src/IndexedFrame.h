@@ -0,0 +1,99 @@
+#ifndef LEDCON_IndexedFrame_h
+#define LEDCON_IndexedFrame_h
+
+#include <FastLED.h>
+
+namespace LEDStripController
+{
+    /**
+     * Palette-indexed framebuffer, see Controller::setLEDs(IndexedFrame&).
+     * Each LED is stored as one byte, an index into a palette of up to paletteSize colors, instead of a 3 byte CRGB,
+     * so a strip needs a third of the RAM.
+     * The frame is only expanded to RGB as it is sent, chunkSize pixels at a time, by a PixelWriter.
+     */
+    class IndexedFrame
+    {
+    public:
+        static const uint8_t paletteSize = 16;
+        // Pixels expanded per PixelWriter call, the chunk is kept on the stack while the frame is sent
+        static const uint8_t chunkSize = 16;
+
+        /**
+         * Output stage, sends consecutive pixels of a frame to the strip.
+         * Pixels are already scaled to the brightness. A frame starts with first == 0 and ends with first + count == numLEDs.
+         * The strip's driver must accept the frame in pieces, e.g. SPI for clocked chipsets (see SPIWriters for APA102 and WS2801).
+         */
+        typedef void (*PixelWriter)(const CRGB *pixels, uint8_t count, int first, int numLEDs);
+
+    private:
+        uint8_t *_indices;
+        int _length;
+        PixelWriter _writer;
+
+        CRGB _palette[paletteSize];
+        uint8_t _numColors;
+        // Fraction of each scaled palette channel not yet shown, in 256ths, for dithering
+        uint8_t _error[paletteSize][3];
+
+    public:
+        /**
+         * @brief Construct a new indexed frame
+         * @param indices One byte per LED, must outlive the frame
+         * @param length Number of LEDs
+         * @param writer Output stage the frame is sent through
+         */
+        IndexedFrame(uint8_t *indices, int length, PixelWriter writer);
+
+        /**
+         * @brief Get the palette index of a color, adding it to the palette if needed.
+         * Once the palette is full the last entry is replaced, changing the LEDs already using it.
+         * @param col Color to find
+         * @return uint8_t Index in the palette
+         */
+        uint8_t findColor(const CRGB &col);
+        /**
+         * @brief Set LEDs to a palette index
+         * @param first Index of the first LED
+         * @param count Number of LEDs
+         * @param idx Palette index
+         */
+        void fill(int first, int count, uint8_t idx);
+        /**
+         * @brief Set LEDs to a color.
+         * Filling the whole frame starts the palette again with only this color, so effects redrawing the whole
+         * frame with a new color (e.g. a fade) do not use up the palette.
+         * @param first Index of the first LED
+         * @param count Number of LEDs
+         * @param col Color to fill with
+         */
+        void fill(int first, int count, const CRGB &col);
+        /**
+         * @brief Empty the palette, before an effect sets up every color it draws with
+         */
+        void clearPalette();
+
+        /**
+         * @brief Expand the frame to RGB at the given brightness and send it through the PixelWriter
+         * @param brightness Scale applied to the palette before expanding
+         * @param dither Carry the fraction lost when scaling each palette channel over to the next frame,
+         * so over several frames the LEDs average to the exact scaled color
+         */
+        void show(uint8_t brightness, bool dither = false);
+
+        uint8_t *getIndices();
+        int getLength();
+        /**
+         * @brief Get a palette entry
+         * @param idx Palette index
+         * @return CRGB Black if the entry is not in use
+         */
+        CRGB getColor(uint8_t idx);
+        /**
+         * @brief Get the number of palette entries in use
+         * @return uint8_t
+         */
+        uint8_t getNumColors();
+    };
+};
+
+#endif
@@ -9,51 +9,147 @@ namespace LEDStripController {
         return val;
     }
 
+    namespace {
+        // EEPROM layout used by settings version 1: a version byte followed by the Settings struct
+        const int legacyVersionAddr = 0;
+        const int legacySettingsAddr = 1;
+        const uint16_t allKeys = ((uint32_t)1 << Keys::count) - 1;
+        // Version 1 stored the Settings struct up to and including the colors
+        const uint8_t legacySize = Keys::colors + sizeof(CRGB) * maxColors;
+        const uint16_t legacyKeys = ((uint32_t)1 << (Keys::colors + maxColors)) - 1;
+        // Longest gap between frames (us) counted towards effect steps, so a stall does not skip a whole animation
+        const unsigned long maxStepTime = 1000000;
+        // Order of the 8 dithering offsets, so consecutive frames are spread over the range
+        const uint8_t ditherOrder[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+
+        // Power estimate of one LED, see Controller::setPowerBudget
+        uint16_t channelSum(const CRGB &col) {
+            return col.r + col.g + col.b;
+        }
+
+        template<typename T>
+        void swapValues(T &a, T &b) {
+            T tmp = a;
+            a = b;
+            b = tmp;
+        }
+    };
+
     #pragma region Constructors
 
-    Controller::Controller()
+    Controller::Controller(uint16_t storeStart, uint16_t storeLength):
+        Controller(Effects::all, sizeof Effects::all / sizeof Effects::all[0], storeStart, storeLength) {}
+
+    Controller::Controller(const Effect *effects, uint8_t numEffects, uint16_t storeStart, uint16_t storeLength):
+        _store(storeStart, storeLength)
     {
-        // Check for EEPROM version mismatch
-        if (EEPROM.read(Addrs::version) != version) {
-            // Perform version update
-            CRGB color(255, 255, 255);
-
-            setEffect(0);
-            setBrightness(64);
-            setEnabled(true);
-            setMinimumColorIndex(0);
-            setMaximumColorIndex(0);
-            setFPS(60);
-            EEPROM.update(Addrs::version, version);
+        _leds = NULL;
+        _numLEDs = 0;
+        _output = NULL;
+        _frame = NULL;
+        _correction = NULL;
+        _dither = false;
+        _ditherFrame = 0;
+        _ledsScaled = false;
+
+        // The effect table must be set before the version check, as setEffect looks ids up in it
+        _effects = effects;
+        _numEffects = numEffects;
+        _effectIdx = 0;
+
+        _redraw = false;
+        _redrawPending = true;
+        _frameDirty = false;
+        _shownBrightness = 0;
+        _lastShow = 0;
+        _refreshInterval = 0;
+        _skippedShows = 0;
+        _frames = 0;
+        _nextFrame = micros();
+        _paused = false;
+        _lastStep = micros();
+        _stepTime = 0;
+        _steps = 0;
+        memset((void*)&_transition, 0, sizeof _transition);
+        _powerBudget = 0;
+        _powerSum = 0;
+#if LEDCON_STATS
+        _stats.reset();
+#endif
+        _numSegments = 0;
+        _owner = NULL;
+        _batch = false;
+        _batchFailed = false;
+        _batchStart = 0;
+        _batchEffectChanged = false;
+
+        // Load saved values into RAM, all getters are served from this copy
+        memset((void*)&_settings, 0, sizeof _settings);
+        _dirty = 0;
+        _lastChange = 0;
+        _commitDelay = defaultCommitDelay;
+
+        // Bit n set when key n was found in the store
+        uint16_t found = 0;
+        _store.load();
+        for (uint8_t key = 0; key < Keys::count; key++) {
+            if (_store.read(key, (uint8_t*)&_settings + Keys::offset(key))) found |= (uint16_t)1 << key;
+        }
+
+        // Nothing in the store yet, migrate settings saved in the version 1 layout.
+        // Only a store at the start of EEPROM replaced that layout, elsewhere address 0 belongs to another store.
+        if (found == 0 && _store.start() == legacyVersionAddr && EEPROM.read(legacyVersionAddr) == 1) {
+            for (uint8_t i = 0; i < legacySize; i++) {
+                ((uint8_t*)&_settings)[i] = EEPROM.read(legacySettingsAddr + i);
+            }
+            found = legacyKeys;
+            _dirty = legacyKeys;
+        }
+
+        // Values the setters would never store (e.g. a corrupt legacy block) are replaced like missing ones
+        uint16_t invalid = 0;
+        if (_settings.fps == 0) invalid |= (uint16_t)1 << Keys::fps;
+        if (_settings.speed == 0) invalid |= (uint16_t)1 << Keys::speed;
+        if (_settings.currentColorIdx >= maxColors || _settings.finalColorIdx >= maxColors ||
+            _settings.finalColorIdx < _settings.currentColorIdx) {
+            invalid |= ((uint16_t)1 << Keys::currentColorIdx) | ((uint16_t)1 << Keys::finalColorIdx);
+        }
+
+        // Write defaults for missing settings, on first boot or for keys added since the settings were saved
+        uint16_t missing = (allKeys & ~found) | invalid;
+        if (missing) {
+            Settings defaults;
+            memset((void*)&defaults, 0, sizeof defaults);
+            defaults.brightness = 64;
+            defaults.enabled = true;
+            defaults.fps = 60;
+            defaults.speed = 100;
 
             // Default all colors to white
             for (int i = 0; i < maxColors; i++)
             {
-                setColor(color, i);
+                defaults.colors[i] = CRGB(255, 255, 255);
+            }
+
+            for (uint8_t key = 0; key < Keys::count; key++) {
+                if (missing & ((uint16_t)1 << key)) {
+                    memcpy((uint8_t*)&_settings + Keys::offset(key), (const uint8_t*)&defaults + Keys::offset(key), Keys::size(key));
+                }
             }
+            _dirty |= missing;
         }
+        if (_dirty) save();
         // Initalise color index offset
         _colOffset = 0;
 
-        // Load saved values
-        FastLED.setBrightness(getBrightness());
-        FastLED.setMaxRefreshRate(getFPS());
-
-        // Setup effects linked list
-        effects = LinkedList<void (*)(Controller&)>();
-        effects.add(Effects::Color::fill);
-        effects.add(Effects::Color::alternateFill);
-        effects.add(Effects::Color::fade);
-        effects.add(Effects::Color::fillEmpty);
-        effects.add(Effects::Color::fillEmptyMiddle);
-        effects.add(Effects::Rainbow::fill);
-        effects.add(Effects::Rainbow::fillEmpty);
-        effects.add(Effects::Rainbow::cycle);
-        effects.add(Effects::Rainbow::spinCycle);
-        effects.add(Effects::Random::fill);
-        effects.add(Effects::Random::fade);
-        effects.add(Effects::Random::fillEmpty);
-        effects.add(Effects::Random::fillEmptyMiddle);
+        // Load saved values, the frame rate is kept by mainloop rather than FastLED.show()
+        applyBrightness();
+
+        // Start the saved effect, falling back to the first effect if it is no longer in the table
+        int idx = findEffect(getEffect());
+        _effectIdx = idx < 0 ? 0 : idx;
+        setSetting(Keys::effect, &_effects[_effectIdx].id);
+        startEffect();
     }
 
     Controller::~Controller()
@@ -67,20 +163,57 @@ namespace LEDStripController {
     void Controller::setLEDs(CRGB *leds, int numLEDs) { 
         _leds = leds;
         _numLEDs = numLEDs;
-        // Ensure framerate is correct for new leds
-        FastLED.setMaxRefreshRate(getFPS());
+        _output = NULL;
+        _frame = NULL;
+        redraw();
+        for (uint8_t s = 0; s < _numSegments; s++) bindSegment(s);
+    }
+
+    void Controller::setLEDs(CLEDController &output) {
+        setLEDs(output.leds(), output.size());
+        _output = &output;
+        if (_dither) applyDither();
+    }
+
+    void Controller::setLEDs(IndexedFrame &frame) {
+        setLEDs((CRGB*)NULL, frame.getLength());
+        _frame = &frame;
     }
 
     void Controller::setBrightness(uint8_t val) {
-        EEPROM.update(Addrs::brightness, val); FastLED.setBrightness(val);
+        setSetting(Keys::brightness, &val); applyBrightness();
     }
 
     void Controller::setEffect(uint8_t val) {
-        EEPROM.update(Addrs::effect, clamp(val, 0, effects.size() - 1));
+        int idx = findEffect(val);
+        if (idx < 0) idx = 0;
+
+        // Only one effect can be fading out, so one still fading is dropped
+        if (_transition.active) endTransition();
+
+        if (_transition.leds && _transition.length > 0 && _transition.ms && _numLEDs > 0 && !_frame && getEnabled()) {
+            // The current effect keeps running as the outgoing effect, it is torn down once it has faded out
+            _transition.active = true;
+            _transition.elapsed = 0;
+            _transition.effectIdx = _effectIdx;
+            memcpy((void*)&_transition.state, (const void*)&_state, sizeof _state);
+            _transition.stepTime = _stepTime;
+            _transition.colOffset = _colOffset;
+            // Its buffer holds nothing yet
+            _transition.redraw = true;
+        } else if (_effects[_effectIdx].teardown) {
+            _effects[_effectIdx].teardown(*this);
+        }
+
+        _effectIdx = idx;
+        setSetting(Keys::effect, &_effects[_effectIdx].id);
+        startEffect();
+        if (_batch) _batchEffectChanged = true;
     }
 
     void Controller::setEnabled(bool val) {
-        EEPROM.update(Addrs::enabled, val);
+        uint8_t enabled = val;
+        setSetting(Keys::enabled, &enabled);
     }
 
     void Controller::setColor(CRGB val) {
@@ -94,8 +227,7 @@ namespace LEDStripController {
 
     void Controller::setColor(CRGB val, int idx) {
         idx = clamp(idx, 0, maxColors - 1);
-        idx = Addrs::colors + idx * sizeof(CRGB);
-        EEPROM.put<CRGB>(idx, val);
+        setSetting(Keys::colors + idx, val.raw);
     }
 
     void Controller::setColor(uint8_t r, uint8_t g, uint8_t b, int idx) {
@@ -105,26 +237,158 @@ namespace LEDStripController {
 
     void Controller::setFPS(uint8_t val) {
         val = clamp(val, 1, 255);
-        EEPROM.update(Addrs::fps, val);
-        FastLED.setMaxRefreshRate(val);
+        setSetting(Keys::fps, &val);
+    }
+
+    void Controller::setSpeed(uint8_t val) {
+        val = clamp(val, 1, 255);
+        setSetting(Keys::speed, &val);
     }
 
     void Controller::setMinimumColorIndex(uint8_t val) { 
         val = clamp(val, 0, maxColors);
         setMaximumColorIndex(val + getMaximumColorIndex());
-        EEPROM.update(Addrs::currentColorIdx, val);
+        setSetting(Keys::currentColorIdx, &val);
     }
 
     void Controller::setMaximumColorIndex(uint8_t val) {
         val = clamp(val, getMinimumColorIndex(), maxColors - 1);
-        EEPROM.update(Addrs::finalColorIdx, val); 
+        setSetting(Keys::finalColorIdx, &val);
     }
 
     void Controller::setColorIndexOffset(int val) {
         val = clamp(val, 0, getMaximumColorIndex());
+        if (val != _colOffset) redraw();
         _colOffset = val;
     }
 
+    void Controller::setCommitDelay(unsigned long ms) {
+        _commitDelay = ms;
+    }
+
+    void Controller::setRefreshInterval(unsigned long ms) {
+        _refreshInterval = ms;
+    }
+
+    void Controller::setPaused(bool val) {
+        if (_paused && !val) {
+            redraw();
+            _nextFrame = micros();
+            // Carry on from where the effect was paused
+            _lastStep = micros();
+        }
+        _paused = val;
+        for (uint8_t s = 0; s < _numSegments; s++) _segments[s]->setPaused(val);
+    }
+
+    bool Controller::setSegmentRange(uint8_t idx, int start, int length) {
+        if (idx < 1 || idx > _numSegments) return false;
+        _segmentStart[idx - 1] = start;
+        _segmentLength[idx - 1] = length;
+        bindSegment(idx - 1);
+        // The LEDs the segment has left show this Controller's effect again
+        redraw();
+        requestFrame();
+        return true;
+    }
+
+    void Controller::setTransition(CRGB *buffer, int length, uint16_t ms) {
+        if (_transition.active) endTransition();
+        _transition.leds = buffer;
+        _transition.length = buffer ? length : 0;
+        _transition.ms = ms;
+    }
+
+    void Controller::setTransitionTime(uint16_t ms) {
+        _transition.ms = ms;
+    }
+
+    void Controller::setSetting(uint8_t key, const uint8_t *val) {
+        uint8_t *bytes = (uint8_t*)&_settings + Keys::offset(key);
+        if (memcmp(bytes, val, Keys::size(key)) == 0) return;
+        memcpy(bytes, val, Keys::size(key));
+        _dirty |= (uint16_t)1 << key;
+        _lastChange = millis();
+        redraw();
+        // Show the change on the next mainloop call instead of waiting for the frame period
+        requestFrame();
+    }
+
+    void Controller::requestFrame() {
+        if (_owner) _owner->requestFrame();
+        else _nextFrame = micros();
+    }
+
+    void Controller::applyBrightness() {
+        if (!_owner && !_output && !_frame) FastLED.setBrightness(limitBrightness(getBrightness()));
+    }
+
+    uint8_t Controller::outputBrightness() {
+        return _output || _frame ? limitBrightness(getBrightness()) : FastLED.getBrightness();
+    }
+
+    void Controller::setPowerBudget(uint16_t mA) {
+        _powerBudget = mA;
+        // The estimate is not kept without a budget
+        measurePower();
+        applyBrightness();
+        requestFrame();
+    }
+
+    void Controller::setCorrection(const ColorCorrection *correction) {
+        _correction = correction;
+        redraw();
+    }
+
+    void Controller::setDither(bool val) {
+        _dither = val;
+        applyDither();
+        requestFrame();
+    }
+
+    void Controller::applyDither() {
+        if (_owner || _frame) return;
+        // FastLED's dithering would add to the Controller's (and is only applied above 100 fps by FastLED.show())
+        uint8_t mode = _dither ? DISABLE_DITHER : BINARY_DITHER;
+        if (_output) _output->setDither(mode);
+        else FastLED.setDither(mode);
+    }
+
+    bool Controller::dithering() {
+        // Nothing is lost to scaling at full brightness, and nothing is shown while off
+        uint8_t brightness = outputBrightness();
+        return _dither && getEnabled() && brightness > 0 && brightness < 255;
+    }
+
+    void Controller::measurePower() {
+        uint32_t sum = 0;
+        if (_powerBudget && _frame) {
+            const uint8_t *indices = _frame->getIndices();
+            for (int i = 0; i < _numLEDs; i++) sum += channelSum(_frame->getColor(indices[i]));
+        } else if (_powerBudget && _leds) {
+            for (int i = 0; i < _numLEDs; i++) sum += channelSum(_leds[i]);
+        }
+        _powerSum = sum;
+    }
+
+    uint8_t Controller::limitBrightness(uint8_t val) {
+        if (!_powerBudget) return val;
+        uint32_t idle = (uint32_t)_numLEDs * Power::idlemA;
+        if (idle >= _powerBudget) return 0;
+
+        // Current at full brightness, which scales linearly with brightness
+        uint32_t full = _powerSum * Power::channelmA / 255;
+        if (full == 0) return val;
+        uint32_t limit = (_powerBudget - idle) * 255 / full;
+        return limit < val ? limit : val;
+    }
+
+    void Controller::bindSegment(uint8_t idx) {
+        int start = clamp(_segmentStart[idx], 0, _numLEDs);
+        int length = clamp(_segmentLength[idx], 0, _numLEDs - start);
+        _segments[idx]->setLEDs(_leds ? _leds + start : NULL, _leds ? length : 0);
+    }
+
     #pragma endregion
 
     #pragma region Getters
@@ -133,20 +397,56 @@ namespace LEDStripController {
         return _leds;
     }
 
+    uint16_t Controller::getPowerBudget() {
+        return _powerBudget;
+    }
+
+    uint16_t Controller::getPowerDraw() {
+        uint32_t mA = (uint32_t)_numLEDs * Power::idlemA + _powerSum * Power::channelmA / 255 * outputBrightness() / 255;
+        return mA > 0xFFFF ? 0xFFFF : mA;
+    }
+
+    const ColorCorrection* Controller::getCorrection() {
+        return _correction;
+    }
+
+    bool Controller::getDither() {
+        return _dither;
+    }
+
+    IndexedFrame* Controller::getFrame() {
+        return _frame;
+    }
+
     int Controller::getNumLEDs() {
         return _numLEDs;
     }
 
     uint8_t Controller::getBrightness() {
-        return EEPROM.read(Addrs::brightness);
+        return _settings.brightness;
     }
 
     uint8_t Controller::getEffect() {
-        return EEPROM.read(Addrs::effect);
+        return _settings.effect;
+    }
+
+    const Effect* Controller::getEffects() {
+        return _effects;
+    }
+
+    uint8_t Controller::getNumEffects() {
+        return _numEffects;
+    }
+
+    int Controller::findEffect(uint8_t id) {
+        for (uint8_t idx = 0; idx < _numEffects; idx++) {
+            if (_effects[idx].id == id) return idx;
+        }
+        return -1;
     }
 
     bool Controller::getEnabled() {
-        return EEPROM.read(Addrs::enabled);
+        return _settings.enabled;
     }
 
     CRGB Controller::getColor() { 
@@ -154,48 +454,538 @@ namespace LEDStripController {
     }
 
     CRGB Controller::getColor(int idx) {
-        CRGB color;
         if (idx < 0) idx = 0;
-        if (idx > maxColors) idx = maxColors - 1;
-        idx = Addrs::colors + idx * sizeof(CRGB);
-        EEPROM.get<CRGB>(idx, color);
-        return color;
+        if (idx >= maxColors) idx = maxColors - 1;
+        return _settings.colors[idx];
     }
 
     uint8_t Controller::getFPS() {
-        return EEPROM.read(Addrs::fps);
+        return _settings.fps;
+    }
+
+    uint8_t Controller::getSpeed() {
+        return _settings.speed;
+    }
+
+    uint16_t Controller::getSteps() {
+        return _steps;
+    }
+
+    uint16_t Controller::getTransitionTime() {
+        return _transition.ms;
+    }
+
+    bool Controller::inTransition() {
+        return _transition.active;
+    }
+
+    size_t Controller::getTransitionRAM() {
+        return sizeof _transition + _transition.length * sizeof(CRGB);
     }
 
     int Controller::getColorIndexOffset() {
         return _colOffset;
     }
 
+    unsigned long Controller::getCommitDelay() {
+        return _commitDelay;
+    }
+
+    bool Controller::hasUnsavedChanges() {
+        for (uint8_t s = 0; s < _numSegments; s++) {
+            if (_segments[s]->hasUnsavedChanges()) return true;
+        }
+        return _dirty != 0;
+    }
+
+    SettingsStore& Controller::getStore() {
+        return _store;
+    }
+
+    EffectState& Controller::getState() {
+        return _state;
+    }
+
+    unsigned long Controller::getRefreshInterval() {
+        return _refreshInterval;
+    }
+
+    unsigned long Controller::getSkippedShows() {
+        return _skippedShows;
+    }
+
+    unsigned long Controller::getFrames() {
+        return _frames;
+    }
+
+    bool Controller::getPaused() {
+        return _paused;
+    }
+
+    bool Controller::inBatch() {
+        return _batch;
+    }
+
+    Controller* Controller::getSegment(uint8_t idx) {
+        if (idx == 0) return this;
+        return idx <= _numSegments ? _segments[idx - 1] : NULL;
+    }
+
+    uint8_t Controller::getNumSegments() {
+        return _numSegments + 1;
+    }
+
+    int Controller::getSegmentStart(uint8_t idx) {
+        if (idx < 1 || idx > _numSegments) return 0;
+        return clamp(_segmentStart[idx - 1], 0, _numLEDs);
+    }
+
+    bool Controller::isSegment() {
+        return _owner != NULL;
+    }
+
+#if LEDCON_STATS
+    FrameStats& Controller::getStats() {
+        return _stats;
+    }
+#endif
+
     uint8_t Controller::getMinimumColorIndex() {
-        return EEPROM.read(Addrs::currentColorIdx);
+        return _settings.currentColorIdx;
     }
 
     uint8_t Controller::getMaximumColorIndex() {
-        return EEPROM.read(Addrs::finalColorIdx);
+        return _settings.finalColorIdx;
     }
 
     #pragma endregion
 
     #pragma region Interaction functions
 
-    void Controller::mainloop() 
+    bool Controller::mainloop()
+    {
+        if (_batch && millis() - _batchStart >= batchTimeout) abortBatch();
+
+        bool drawn = !_paused && !_batch && frameDue();
+        if (drawn) drawFrame();
+
+        // Commit settings once they have stopped changing
+        commitSettings();
+        return drawn;
+    }
+
+    void Controller::commitSettings() {
+        if (!_batch && _dirty && millis() - _lastChange >= _commitDelay) writeSettings();
+        for (uint8_t s = 0; s < _numSegments; s++) _segments[s]->commitSettings();
+    }
+
+    bool Controller::frameDue() {
+        // Signed difference, so the check survives micros() wrapping around
+        return (long)(micros() - _nextFrame) >= 0;
+    }
+
+    unsigned long Controller::timeUntilFrame() {
+        return frameDue() ? 0 : _nextFrame - micros();
+    }
+
+    unsigned long Controller::getNextFrame() {
+        return _nextFrame;
+    }
+
+    void Controller::show() {
+        if (_owner) _owner->show();
+        else if (_output) _output->showLeds(limitBrightness(getBrightness()));
+        else if (_frame) _frame->show(limitBrightness(getBrightness()), _dither);
+        else FastLED.show();
+    }
+
+    void Controller::showDithered() {
+        uint16_t scale = outputBrightness() + 1;
+        uint8_t frame = _ditherFrame++;
+        for (int i = 0; i < _numLEDs; i++) {
+            // Added before dropping the fraction, each LED starts the cycle on a different frame so neighbours do not step together
+            uint8_t offset = ditherOrder[(frame + i) & 7] * 32 + 16;
+            CRGB &led = _leds[i];
+            led.r = (led.r * scale + offset) >> 8;
+            led.g = (led.g * scale + offset) >> 8;
+            led.b = (led.b * scale + offset) >> 8;
+        }
+        if (_output) _output->showLeds(255);
+        else FastLED.show(255);
+        _ledsScaled = true;
+        redraw();
+    }
+
+    void Controller::showWritten() {
+        if (_owner) {
+            _owner->showWritten();
+            return;
+        }
+        if (_powerBudget) {
+            measurePower();
+            applyBrightness();
+        }
+        show();
+        _shownBrightness = outputBrightness();
+        _lastShow = millis();
+    }
+
+    void Controller::drawFrame()
     {
+        // Schedule from when this frame was due so the rate does not drift,
+        // but start over if a whole period has been missed rather than rendering a burst of frames
+        unsigned long now = micros();
+        unsigned long period = 1000000UL / getFPS();
+#if LEDCON_STATS
+        // Late by a quarter of a period or more, and whole periods missed
+        unsigned long lateness = now - _nextFrame;
+        if (lateness >= period / 4) _stats.late++;
+        _stats.dropped += lateness / period;
+#endif
+        _nextFrame += period;
+        if ((long)(now - _nextFrame) >= 0) _nextFrame = now + period;
+
+        _frames++;
+#if LEDCON_STATS
+        _stats.frames++;
+#endif
+        renderEffect(now);
+
+        // Segments are drawn over this Controller's effect, in full whenever it has drawn over them.
+        // Turning this Controller off turns its segments off too.
         if (getEnabled()) {
-            effects[getEffect()](*this);
+            bool background = _frameDirty;
+            for (uint8_t s = 0; s < _numSegments; s++) {
+                Controller *segment = _segments[s];
+                if (background) segment->redraw();
+                segment->renderEffect(now);
+                if (segment->_frameDirty) markDirty();
+            }
+        }
+
+        if (_powerBudget) {
+            // Segments draw with their own Controllers, so the strip is measured again whenever it changes
+            if (_numSegments && _frameDirty) measurePower();
+            applyBrightness();
+        }
+
+        // Only send the frame if it, or the brightness, has changed (or the keep-alive interval has passed, or it is dithered)
+        bool refresh = (_refreshInterval && millis() - _lastShow >= _refreshInterval) || dithering();
+        if (_frameDirty || refresh || outputBrightness() != _shownBrightness) {
+#if LEDCON_STATS
+            unsigned long showStart = micros();
+            if (dithering() && _leds) showDithered();
+            else show();
+            _stats.show.add(micros() - showStart);
+#else
+            if (dithering() && _leds) showDithered();
+            else show();
+#endif
+            _shownBrightness = outputBrightness();
+            _lastShow = millis();
         } else {
-            Effects::clear(*this);
+            _skippedShows++;
         }
-        FastLED.show();
+    }
+
+    void Controller::renderEffect(unsigned long now)
+    {
+        // Redraws requested during the previous frame apply to this one
+        _redraw = _redrawPending;
+        _redrawPending = false;
+        _frameDirty = false;
+        bool scaled = _ledsScaled;
+        _ledsScaled = false;
+
+        unsigned long elapsed = now - _lastStep;
+        _lastStep = now;
+        if (elapsed > maxStepTime) elapsed = maxStepTime;
+        _steps = takeSteps(elapsed);
+
+        const Effect &effect = _effects[_effectIdx];
+        // Effects that only draw CRGB LEDs are left out when drawing to an IndexedFrame
+        bool drawable = !_frame || (effect.flags & EffectFlags::indexed);
+        if (getEnabled() && drawable) {
+            // The outgoing effect of a transition draws to its own buffer, and is blended over the frame of the incoming one
+            if (_transition.active) stepTransition(elapsed);
+#if LEDCON_STATS
+            unsigned long renderStart = micros();
+            effect.step(*this);
+            _stats.getRender(_effectIdx).add(micros() - renderStart);
+#else
+            effect.step(*this);
+#endif
+            if (!(effect.flags & EffectFlags::tracksChanges)) markDirty();
+            // Effects drawing through the base functions keep the power estimate up to date, unless blended by a transition
+            // or drawing over a frame scaled by dithering
+            bool tracked = (effect.flags & EffectFlags::tracksPower) && !_transition.active && !scaled;
+            if (_transition.active) blendTransition(elapsed);
+            if (_powerBudget && _frameDirty && !tracked && !_numSegments) measurePower();
+        } else {
+            if (_transition.active) endTransition();
+            if (_redraw) {
+                Effects::clear(*this);
+                markDirty();
+            }
+        }
+
+        // FastLED's brightness applies to the whole strip, so a segment is dimmed by scaling its pixels.
+        // The effect then draws its whole range again next frame, rather than drawing over scaled pixels.
+        if (_owner && getEnabled() && getBrightness() < 255) {
+            nscale8(_leds, _numLEDs, getBrightness());
+            redraw();
+        }
+    }
+
+    uint16_t Controller::takeSteps(unsigned long elapsed) {
+        // Steps due since the previous frame at the effect's speed, so animation speed does not depend on the frame rate.
+        // Time is kept in microseconds and left over time carries to the next frame, so no steps are lost to rounding.
+        uint32_t rate = (uint32_t)_effects[_effectIdx].speed * getSpeed();
+        if (rate == 0) return 0;
+
+        // Microseconds per step, the speed setting is a percentage
+        unsigned long stepPeriod = 100000000UL / rate;
+        _stepTime += elapsed;
+        unsigned long steps = _stepTime / stepPeriod;
+        _stepTime -= steps * stepPeriod;
+        return steps > 0xFFFF ? 0xFFFF : steps;
+    }
+
+    int Controller::transitionScale() {
+        int scale = (_numLEDs + _transition.length - 1) / _transition.length;
+        return scale > 0 ? scale : 1;
+    }
+
+    void Controller::swapTransition() {
+        swapValues(_effectIdx, _transition.effectIdx);
+        swapValues(_state, _transition.state);
+        swapValues(_stepTime, _transition.stepTime);
+        swapValues(_colOffset, _transition.colOffset);
+        swapValues(_redrawPending, _transition.redraw);
+    }
+
+    void Controller::stepTransition(unsigned long elapsed) {
+        // The outgoing effect sees the buffer as its LEDs, one pixel per scale LEDs
+        CRGB *leds = _leds;
+        int numLEDs = _numLEDs;
+        bool redraw = _redraw;
+        uint16_t steps = _steps;
+        int scale = transitionScale();
+        _leds = _transition.leds;
+        _numLEDs = (numLEDs + scale - 1) / scale;
+
+        swapTransition();
+        _redraw = _redrawPending;
+        _redrawPending = false;
+        _steps = takeSteps(elapsed);
+        _effects[_effectIdx].step(*this);
+        swapTransition();
+
+        _leds = leds;
+        _numLEDs = numLEDs;
+        _redraw = redraw;
+        _steps = steps;
+    }
+
+    void Controller::blendTransition(unsigned long elapsed) {
+        _transition.elapsed += elapsed;
+        unsigned long duration = (unsigned long)_transition.ms * 1000;
+        if (_transition.elapsed >= duration) {
+            // The incoming effect drew the whole frame, as the previous blend requested a redraw
+            endTransition();
+            return;
+        }
+
+        // Share of the outgoing effect, falling from 255 to 0 over the duration
+        unsigned long amount = _transition.elapsed / ((duration >> 8) + 1);
+        uint8_t outgoing = 255 - (amount > 255 ? 255 : amount);
+
+        // Each buffer pixel is blended into the LEDs it covers
+        int scale = transitionScale();
+        CRGB *out = _transition.leds;
+        for (int i = 0; i < _numLEDs; out++) {
+            int end = i + scale < _numLEDs ? i + scale : _numLEDs;
+            for (; i < end; i++) nblend(_leds[i], *out, outgoing);
+        }
+
+        // The blend changes every pixel, so the incoming effect must draw its whole frame again next time
+        markDirty();
+        redraw();
+    }
+
+    void Controller::endTransition() {
+        if (!_transition.active) return;
+        _transition.active = false;
+
+        const Effect &outgoing = _effects[_transition.effectIdx];
+        if (outgoing.teardown) {
+            // Teardown sees the outgoing effect's own state and LEDs
+            CRGB *leds = _leds;
+            int numLEDs = _numLEDs;
+            int scale = transitionScale();
+            _leds = _transition.leds;
+            _numLEDs = (numLEDs + scale - 1) / scale;
+            swapTransition();
+            outgoing.teardown(*this);
+            swapTransition();
+            _leds = leds;
+            _numLEDs = numLEDs;
+        }
+        markDirty();
+    }
+
+    void Controller::markDirty() {
+        _frameDirty = true;
+    }
+
+    CRGB Controller::correct(const CRGB &col) {
+        if (!_correction) return col;
+        return CRGB(pgm_read_byte(_correction->red + col.r), pgm_read_byte(_correction->green + col.g), pgm_read_byte(_correction->blue + col.b));
+    }
+
+    void Controller::noteFill(int first, int count, const CRGB &col) {
+        if (!_powerBudget) return;
+        if (first < 0) { count += first; first = 0; }
+        if (count > _numLEDs - first) count = _numLEDs - first;
+        if (count <= 0) return;
+
+        // Only the LEDs being replaced are read, unless the whole strip is
+        if (count == _numLEDs) _powerSum = 0;
+        else {
+            for (int i = first; i < first + count; i++) {
+                _powerSum -= channelSum(_frame ? _frame->getColor(_frame->getIndices()[i]) : _leds[i]);
+            }
+        }
+        _powerSum += (uint32_t)channelSum(col) * count;
+    }
+
+    void Controller::redraw() {
+        _redrawPending = true;
+    }
+
+    bool Controller::needsRedraw() {
+        return _redraw;
+    }
+
+    void Controller::startEffect() {
+        redraw();
+        memset((void*)&_state, 0, sizeof _state);
+        _lastStep = micros();
+        _stepTime = 0;
+        _steps = 0;
+        if (_effects[_effectIdx].init) _effects[_effectIdx].init(*this);
     }
 
     void Controller::advanceColor() {
         _colOffset++;
         // Wrap around handling
         _colOffset = (_colOffset > getMaximumColorIndex()) ? 0 : _colOffset;
+        redraw();
+    }
+
+    void Controller::save() {
+        writeSettings();
+        for (uint8_t s = 0; s < _numSegments; s++) _segments[s]->save();
+    }
+
+    void Controller::writeSettings() {
+        for (uint8_t key = 0; _dirty; key++, _dirty >>= 1)
+        {
+#if LEDCON_STATS
+            if ((_dirty & 1) && _store.write(key, (uint8_t*)&_settings + Keys::offset(key))) _stats.eepromWrites++;
+#else
+            if (_dirty & 1) _store.write(key, (uint8_t*)&_settings + Keys::offset(key));
+#endif
+        }
+    }
+
+    void Controller::beginBatch() {
+        if (_batch) return;
+        memcpy((void*)&_batchSnapshot, (const void*)&_settings, sizeof _settings);
+        _batchEffectIdx = _effectIdx;
+        memcpy((void*)&_batchState, (const void*)&_state, sizeof _state);
+        _batchStepTime = _stepTime;
+        _batchColOffset = _colOffset;
+        _batchEffectChanged = false;
+        _batch = true;
+        _batchFailed = false;
+        _batchStart = millis();
+        // Segments are drawn with this Controller, so a batch covers them too
+        for (uint8_t s = 0; s < _numSegments; s++) _segments[s]->beginBatch();
+    }
+
+    bool Controller::commitBatch() {
+        if (!_batch) return false;
+        if (_batchFailed) {
+            abortBatch();
+            return false;
+        }
+        _batch = false;
+        _nextFrame = micros();
+        // Frames were held back by the batch, not dropped
+        _lastStep = micros();
+        for (uint8_t s = 0; s < _numSegments; s++) _segments[s]->commitBatch();
+        return true;
+    }
+
+    void Controller::failBatch() {
+        if (_batch) _batchFailed = true;
+    }
+
+    void Controller::abortBatch() {
+        if (!_batch) return;
+        _batch = false;
+
+        for (uint8_t key = 0; key < Keys::count; key++) {
+            if (key != Keys::effect) setSetting(key, (uint8_t*)&_batchSnapshot + Keys::offset(key));
+        }
+        applyBrightness();
+
+        // The effects started by the batch were never shown, so they are dropped rather than faded out
+        if (_batchEffectChanged) {
+            bool kept = false;
+            if (_transition.active) {
+                // The effect from before the batch is fading out, take it back as it was
+                if (_transition.effectIdx == _batchEffectIdx) {
+                    _transition.active = false;
+                    kept = true;
+                } else {
+                    endTransition();
+                }
+            }
+            if (_effects[_effectIdx].teardown) _effects[_effectIdx].teardown(*this);
+            _effectIdx = _batchEffectIdx;
+            setSetting(Keys::effect, &_effects[_effectIdx].id);
+            // An effect already torn down is started again, otherwise it carries on from its state
+            if (!kept && _effects[_effectIdx].teardown) startEffect();
+            else {
+                memcpy((void*)&_state, (const void*)&_batchState, sizeof _state);
+                _stepTime = _batchStepTime;
+            }
+        }
+        _batchEffectChanged = false;
+        _colOffset = _batchColOffset;
+        redraw();
+        _nextFrame = micros();
+        // Frames were held back by the batch, not dropped
+        _lastStep = micros();
+        for (uint8_t s = 0; s < _numSegments; s++) _segments[s]->abortBatch();
+    }
+
+    int Controller::addSegment(Controller &segment, int start, int length) {
+        if (_numSegments >= maxSegments || _owner || _frame || &segment == this || segment._owner || segment._numSegments) return -1;
+
+        segment._owner = this;
+        _segments[_numSegments] = &segment;
+        _segmentStart[_numSegments] = start;
+        _segmentLength[_numSegments] = length;
+        bindSegment(_numSegments);
+        _numSegments++;
+
+        // The segment's constructor set FastLED's brightness to its own
+        applyBrightness();
+        requestFrame();
+        return _numSegments;
     }
 
     #pragma endregion
@@ -3,7 +3,11 @@
 
 #include <EEPROM.h>
 #include <FastLED.h>
-#include <LinkedList.h>
+
+#include "Settings.h"
+#include "FrameStats.h"
+#include "IndexedFrame.h"
+#include "ColorCorrection.h"
 
 namespace LEDStripController
 {
@@ -16,23 +20,130 @@ namespace LEDStripController
      */
     int clamp(int val, int min, int max);
 
-    const int version = 1;
-    const int maxColors = 8;
+    /**
+     * Default time (ms) settings must be left unchanged before they are written to EEPROM
+     */
+    const unsigned long defaultCommitDelay = 2000;
+
+    /**
+     * Time (ms) a batch may stay open before it is aborted, so an interrupted host cannot freeze the strip
+     */
+    const unsigned long batchTimeout = 2000;
+
+    /**
+     * Default effect speed in steps per second, one step per frame at the default 60 fps
+     */
+    const uint16_t defaultEffectSpeed = 60;
+
+    /**
+     * Maximum number of segments a Controller can draw over its own effect, see Controller::addSegment
+     */
+    const uint8_t maxSegments = 4;
+
+    class Controller;
+
+    /**
+     * Animation state for the current lighting effect.
+     * Each Controller owns one, it is zeroed whenever the effect changes.
+     */
+    struct EffectState
+    {
+        // Frame counter / position
+        int i;
+        // Position shown by the previous frame of a wipe effect, which only redraws the pixels that change
+        int drawn;
+        // Direction of iteration
+        bool reverse;
+        // Hue for rainbow effects
+        uint8_t hue;
+        // Color for random effects
+        CHSV color;
+        // Last color drawn by fill and fade, used to skip redrawing an unchanged frame
+        CRGB last;
+        // Last HSV color converted by the base functions, and its RGB value.
+        // Zeroed state is a valid pair, as HSV black converts to RGB black.
+        CHSV hsv;
+        CRGB rgb;
+    };
+
+    /**
+     * Flags describing an Effect
+     */
+    namespace EffectFlags
+    {
+        /**
+         * The effect calls Controller::markDirty whenever it changes the LEDs.
+         * Without this flag every frame is assumed to change.
+         */
+        const uint8_t tracksChanges = 0x01;
+        /**
+         * The effect can draw to an IndexedFrame (see Controller::getFrame), using a few colors at a time.
+         * Effects without this flag leave the strip dark while the Controller draws to an IndexedFrame.
+         */
+        const uint8_t indexed = 0x02;
+        /**
+         * The effect only draws through the base functions (Effects::fill, fade, fillEmpty, ...),
+         * which keep the power estimate up to date as they draw (see Controller::setPowerBudget).
+         * Without this flag the estimate is recomputed over the whole strip after each changed frame, while a budget is set.
+         */
+        const uint8_t tracksPower = 0x04;
+    };
+
+    /**
+     * Power model used by Controller::setPowerBudget, for 5V WS2812B LEDs
+     */
+    namespace Power
+    {
+        // Current drawn by one color channel at full brightness
+        const uint8_t channelmA = 20;
+        // Current drawn by an LED that is off
+        const uint8_t idlemA = 1;
+    };
 
     /**
-     * Namespace containing EEPROM addresses
+     * Descriptor of a lighting effect, used to build effect tables.
+     * id - Identifier used by setEffect and saved in EEPROM, must be unique within a table
+     * name - Name stored in flash (PROGMEM), may be NULL
+     * step - Draws a frame
+     * init, teardown - Optional, run when the Controller switches to and away from the effect
+     * flags - Values from the EffectFlags namespace
+     * speed - Steps per second at 100% speed, see Controller::getSteps. 0 never steps.
      */
-    namespace Addrs
+    struct Effect
     {
-        const int version = 0;
-        const int effect = 1;
-        const int brightness = 2;
-        const int enabled = 3;
-        const int currentColorIdx = 4;
-        const int finalColorIdx = 5;
-        const int fps = 6;
-        const int colors = 7;
-        const int end = colors + sizeof(CRGB) * maxColors;
+        uint8_t id;
+        const char *name;
+        void (*step)(Controller&);
+        void (*init)(Controller&);
+        void (*teardown)(Controller&);
+        uint8_t flags;
+        uint16_t speed;
+
+        constexpr Effect(uint8_t id, const char *name, void (*step)(Controller&), void (*init)(Controller&) = NULL, void (*teardown)(Controller&) = NULL, uint8_t flags = 0, uint16_t speed = defaultEffectSpeed):
+            id(id), name(name), step(step), init(init), teardown(teardown), flags(flags), speed(speed) {}
+    };
+
+    /**
+     * Crossfade between effects, see Controller::setTransition.
+     * While it runs the outgoing effect keeps its own state and draws to the buffer,
+     * and is blended over the frame drawn by the incoming effect.
+     */
+    struct Transition
+    {
+        // Pixels the outgoing effect draws to, each covering one or more LEDs
+        CRGB *leds;
+        int length;
+        // Duration in milliseconds
+        uint16_t ms;
+        bool active;
+        // Microseconds of animation since the crossfade started
+        unsigned long elapsed;
+        // Outgoing effect, with the Controller state it animates
+        uint8_t effectIdx;
+        EffectState state;
+        unsigned long stepTime;
+        int colOffset;
+        bool redraw;
     };
 
     /**
@@ -46,15 +157,209 @@ namespace LEDStripController
         CRGB *_leds;
         int _numLEDs;
         int _colOffset;
+        // FastLED output shown on its own at this Controller's brightness, NULL to use FastLED.show()
+        CLEDController *_output;
+        // Palette-indexed frame drawn to instead of the LEDs, NULL when drawing to CRGB LEDs
+        IndexedFrame *_frame;
+        // Gamma and white balance applied to colors as they are drawn, NULL for none
+        const ColorCorrection *_correction;
+        // Temporal dithering, frames are sent every frame period while it can show fractional levels
+        bool _dither;
+        // Frame counter choosing each LED's dithering offset
+        uint8_t _ditherFrame;
+        // The LEDs hold a frame scaled to the brightness by dithering, rather than what the effect drew
+        bool _ledsScaled;
+
+        Settings _settings;
+        SettingsStore _store;
+        // Bit n set when key n of _settings differs from the store
+        uint16_t _dirty;
+        unsigned long _lastChange;
+        unsigned long _commitDelay;
+
+        EffectState _state;
+
+        // Frame tracking, used to skip FastLED.show() when nothing has changed
+        bool _redraw;
+        bool _redrawPending;
+        bool _frameDirty;
+        uint8_t _shownBrightness;
+        unsigned long _lastShow;
+        unsigned long _refreshInterval;
+        unsigned long _skippedShows;
+        unsigned long _frames;
+
+        // Frame scheduling, micros() time the next frame is due
+        unsigned long _nextFrame;
+        bool _paused;
+
+        // Time based animation: micros() time of the previous frame,
+        // time not yet used up by whole steps, and the steps for the current frame
+        unsigned long _lastStep;
+        unsigned long _stepTime;
+        uint16_t _steps;
+
+        Transition _transition;
+
+        // Current budget in mA, 0 for no limit
+        uint16_t _powerBudget;
+        // Sum of every LED's channels, the power estimate at full brightness
+        uint32_t _powerSum;
+
+#if LEDCON_STATS
+        FrameStats _stats;
+#endif
+
+        // Settings before the open batch, restored if it is aborted
+        Settings _batchSnapshot;
+        // Effect running when the open batch began, taken back without a transition if it is aborted
+        uint8_t _batchEffectIdx;
+        EffectState _batchState;
+        unsigned long _batchStepTime;
+        int _batchColOffset;
+        // An effect was started during the open batch
+        bool _batchEffectChanged;
+        bool _batch;
+        bool _batchFailed;
+        unsigned long _batchStart;
+
+        // Segments drawn over this Controller's effect, and their ranges of the LEDs
+        Controller *_segments[maxSegments];
+        int _segmentStart[maxSegments];
+        int _segmentLength[maxSegments];
+        uint8_t _numSegments;
+        // Controller this one is a segment of, NULL when it drives the strip itself
+        Controller *_owner;
+
+        /**
+         * @brief Render the current effect and show it if it changed
+         */
+        void drawFrame();
+        /**
+         * @brief Step the current effect (or clear the LEDs if disabled), without showing the frame
+         * @param now micros() time of the frame
+         */
+        void renderEffect(unsigned long now);
+        /**
+         * @brief Get the number of steps the current effect advances for the given time, keeping the time left over
+         * @param elapsed Microseconds since the previous frame
+         */
+        uint16_t takeSteps(unsigned long elapsed);
+        /**
+         * @brief Get the number of LEDs each pixel of the transition buffer covers
+         */
+        int transitionScale();
+        /**
+         * @brief Swap the current effect and its state with the outgoing effect of the transition
+         */
+        void swapTransition();
+        /**
+         * @brief Step the outgoing effect of the transition on the transition buffer
+         * @param elapsed Microseconds since the previous frame
+         */
+        void stepTransition(unsigned long elapsed);
+        /**
+         * @brief Blend the outgoing effect over the frame drawn by the incoming one, ending the transition when its time is up
+         * @param elapsed Microseconds since the previous frame
+         */
+        void blendTransition(unsigned long elapsed);
+        /**
+         * @brief Stop the transition, tearing down the outgoing effect
+         */
+        void endTransition();
+        /**
+         * @brief Recompute the power estimate over the whole strip
+         */
+        void measurePower();
+        /**
+         * @brief Limit a brightness to the power budget, using the power estimate
+         */
+        uint8_t limitBrightness(uint8_t val);
+        /**
+         * @brief Make the next frame due immediately, a segment's frames are drawn by its owner
+         */
+        void requestFrame();
+        /**
+         * @brief Apply the brightness setting to FastLED.
+         * Controllers with an output are shown at their own brightness, and segments are dimmed when drawn instead.
+         */
+        void applyBrightness();
+        /**
+         * @brief Turn FastLED's own dithering of the output off while this Controller dithers, segments are dithered by their owner
+         */
+        void applyDither();
+        /**
+         * @brief Check whether frames must be sent even when unchanged, so dithering can alternate levels
+         */
+        bool dithering();
+        /**
+         * @brief Scale the LEDs to the brightness with a dithering offset and send them at full brightness.
+         * The effect then draws its whole frame again next time, rather than drawing over scaled pixels.
+         */
+        void showDithered();
+        /**
+         * @brief Get the brightness the LEDs are shown at
+         */
+        uint8_t outputBrightness();
+        /**
+         * @brief Write this Controller's changed settings to EEPROM, not those of its segments
+         */
+        void writeSettings();
+        /**
+         * @brief Write changed settings (and those of segments) that have been left unchanged for the commit delay
+         */
+        void commitSettings();
+        /**
+         * @brief Point a segment at its range of the LEDs, clamped to the strip
+         * @param idx Index in _segments
+         */
+        void bindSegment(uint8_t idx);
+        // Table of available effects and the index of the current one
+        const Effect *_effects;
+        uint8_t _numEffects;
+        uint8_t _effectIdx;
+
+        /**
+         * @brief Reset the effect state and run the current effect's init function
+         */
+        void startEffect();
+
+        /**
+         * @brief Change a setting, marking it for the next EEPROM commit.
+         * @param key Key from the Keys namespace
+         * @param val New value, Keys::size(key) bytes
+         */
+        void setSetting(uint8_t key, const uint8_t *val);
+    protected:
+        /**
+         * @brief Construct a new Controller using the given effect table
+         * @param effects Table of effects, must outlive the Controller
+         * @param numEffects Number of entries in the table
+         * @param storeStart First EEPROM address used to store settings
+         * @param storeLength Number of EEPROM bytes used to store settings
+         */
+        Controller(const Effect *effects, uint8_t numEffects, uint16_t storeStart, uint16_t storeLength);
     public:
         /**
-         * @brief List of lighting effect functions.
-         * You can edit this list to control what functions are available to the Controller instance.
+         * @brief Construct a new Controller with all built-in effects (Effects::all)
+         * @param storeStart First EEPROM address used to store settings
+         * @param storeLength Number of EEPROM bytes used to store settings, more bytes spread the wear further
+         */
+        Controller(uint16_t storeStart = SettingsStore::defaultStart, uint16_t storeLength = SettingsStore::defaultLength);
+        /**
+         * @brief Construct a new Controller with a custom effect table.
+         * Only effects referenced by the table are linked into the binary.
          * If you want to add your own lighting functions, view the README for more information.
+         * @param effects Table of effects, must outlive the Controller
+         * @param storeStart First EEPROM address used to store settings
+         * @param storeLength Number of EEPROM bytes used to store settings
          */
-        LinkedList<void (*)(Controller&)> effects;
-
-        Controller();
+        template<size_t N>
+        Controller(const Effect (&effects)[N], uint16_t storeStart = SettingsStore::defaultStart, uint16_t storeLength = SettingsStore::defaultLength):
+            Controller(effects, N, storeStart, storeLength)
+        {
+            static_assert(N > 0 && N <= 255, "Effect table must hold 1-255 effects");
+        }
         ~Controller();
 
         #pragma region Setters
@@ -66,8 +371,26 @@ namespace LEDStripController
          */
         void setLEDs(CRGB *leds, int numLEDs);
         /**
-         * @brief Set the Effect index, 
-         * this value will be used to get a lighting function from the effects linked list.
+         * @brief Set the FastLED output this controller instance draws to and shows.
+         * Only this output is sent when a frame is shown, at this Controller's brightness,
+         * so Controllers on different outputs do not change each other's brightness or frame rate.
+         * @param output Output returned by FastLED.addLeds
+         */
+        void setLEDs(CLEDController &output);
+        /**
+         * @brief Draw to a palette-indexed frame instead of an array of CRGB LEDs, using a third of the RAM.
+         * Only effects with the EffectFlags::indexed flag are drawn, and the frame is shown at this Controller's brightness.
+         * Segments and transitions are not drawn in this mode.
+         * @param frame Frame to draw to, must outlive the Controller
+         */
+        void setLEDs(IndexedFrame &frame);
+        /**
+         * @brief Set the Effect id, 
+         * this value will be used to get a lighting function from the effect table.
+         * Ids not in the table select the first effect.
+         * The previous effect is torn down and the new one starts from a fresh EffectState.
+         * With a transition set (see setTransition) the previous effect keeps running until it has faded out,
+         * a transition still running is cut short.
          * @param val The new value
          */
         void setEffect(uint8_t val);
@@ -115,6 +438,13 @@ namespace LEDStripController
          * @param val new value
          */
         void setFPS(uint8_t val);
+
+        /**
+         * @brief Set the animation speed, as a percentage of each effect's own speed.
+         * Effects step by elapsed time, so changing the fps does not change their speed.
+         * @param val New value (1-255)
+         */
+        void setSpeed(uint8_t val);
         
         /**
          * @brief Set the Current Color Index (minimum)
@@ -136,6 +466,87 @@ namespace LEDStripController
          */
         void setColorIndexOffset(int val);
 
+        /**
+         * @brief Set how long settings must be left unchanged before they are written to EEPROM.
+         * Changes made in quick succession (e.g. a brightness slider) then only cost a single write.
+         * @param ms Delay in milliseconds, 0 commits on the next mainloop call
+         */
+        void setCommitDelay(unsigned long ms);
+
+        /**
+         * @brief Set the keep-alive interval.
+         * Frames are normally only sent to the LEDs when they change, this forces a resend after the given time.
+         * @param ms Interval in milliseconds, 0 to only send changed frames
+         */
+        void setRefreshInterval(unsigned long ms);
+
+        /**
+         * @brief Set whether effects are paused.
+         * While paused mainloop draws no frames, so the LEDs can be written from elsewhere (e.g. a PixelStream).
+         * Settings are still committed. The effect redraws the whole frame when resumed.
+         * @param val Desired value
+         */
+        void setPaused(bool val);
+
+        /**
+         * @brief Move or resize a segment.
+         * The range is clamped to the strip, and is not saved in EEPROM.
+         * @param idx Segment number, from 1
+         * @param start Index of the first LED
+         * @param length Number of LEDs
+         * @return true The segment exists
+         */
+        bool setSegmentRange(uint8_t idx, int start, int length);
+
+        /**
+         * @brief Crossfade from one effect to the next when the effect changes, instead of switching on the next frame.
+         * The outgoing effect keeps animating on the given buffer and is blended out over the incoming one.
+         * A buffer shorter than the strip draws the outgoing effect at a lower resolution, each of its pixels covering
+         * several LEDs (e.g. half the strip's length for half resolution), so the RAM cost can be fitted to the board.
+         * See getTransitionRAM.
+         * @param buffer Pixels the outgoing effect draws to, must outlive the Controller. NULL switches effects instantly.
+         * @param length Number of pixels in the buffer
+         * @param ms Duration in milliseconds, 0 switches effects instantly
+         */
+        void setTransition(CRGB *buffer, int length, uint16_t ms);
+        /**
+         * @brief Set the duration of transitions between effects.
+         * Not saved in EEPROM. Only used once a buffer is given with setTransition.
+         * @param ms Duration in milliseconds, 0 switches effects instantly
+         */
+        void setTransitionTime(uint16_t ms);
+
+        /**
+         * @brief Limit the current drawn by the LEDs, dimming frames that would draw more than the budget.
+         * The estimate (see Power) is kept up to date as the base effect functions draw,
+         * so effects with the EffectFlags::tracksPower flag do not read the whole strip each frame.
+         * Not saved in EEPROM.
+         * @param mA Budget in mA, 0 for no limit
+         */
+        void setPowerBudget(uint16_t mA);
+
+        /**
+         * @brief Set the gamma and white balance correction applied to the colors this Controller draws.
+         * Each color is corrected once as the base lighting functions draw it (one table lookup per channel),
+         * not each LED. Not saved in EEPROM.
+         * @param correction Tables built with colorCorrection, must outlive the Controller. NULL for none.
+         */
+        void setCorrection(const ColorCorrection *correction);
+
+        /**
+         * @brief Set whether levels lost to brightness scaling are shown by dithering over several frames.
+         * Unchanged frames are then sent every frame period while the brightness is below 255,
+         * using the time left at the fps to show fractional levels (e.g. in the dark half of a fade).
+         * CRGB LEDs are scaled by the Controller before they are sent, adding an offset that cycles through 8 steps over 8 frames,
+         * so each LED averages to within an eighth of a level of the exact scaled color without any memory per LED.
+         * They hold the scaled frame between frames, and are drawn again by the effect each frame.
+         * FastLED's own dithering of the output (or of every output, with a plain array) is turned off while set, and back on when cleared.
+         * An IndexedFrame carries the error of each palette channel from frame to frame instead.
+         * Not saved in EEPROM.
+         * @param val Desired value
+         */
+        void setDither(bool val);
+
         #pragma endregion
 
         #pragma region Getters
@@ -145,16 +556,37 @@ namespace LEDStripController
          * @return CRGB* Pointer to the array of LED's controlled by this Controller instance
          */
         CRGB* getLEDs();
+        /**
+         * @brief Get the palette-indexed frame effects draw to instead of the LEDs
+         * @return IndexedFrame* NULL when drawing to CRGB LEDs
+         */
+        IndexedFrame* getFrame();
         /**
          * @brief Get the number of LEDs
          * @return int 
          */
         int getNumLEDs();
         /**
-         * @brief Get the current Effect index
+         * @brief Get the current Effect id
          * @return uint8_t 
          */
         uint8_t getEffect();
+        /**
+         * @brief Get the effect table
+         * @return const Effect* 
+         */
+        const Effect* getEffects();
+        /**
+         * @brief Get the number of effects in the effect table
+         * @return uint8_t 
+         */
+        uint8_t getNumEffects();
+        /**
+         * @brief Find an effect in the effect table
+         * @param id Effect id
+         * @return int Index in the table, -1 if not found
+         */
+        int findEffect(uint8_t id);
         /**
          * @brief Get the current Brightness
          * @return uint8_t 
@@ -182,6 +614,54 @@ namespace LEDStripController
          * @return uint8_t 
          */
         uint8_t getFPS();
+        /**
+         * @brief Get the animation speed
+         * @return uint8_t Percentage of each effect's own speed
+         */
+        uint8_t getSpeed();
+        /**
+         * @brief Get the number of steps the current effect should advance this frame.
+         * Found from the time since the previous frame and the effect's speed, so it may be 0 or several
+         * when the frame rate differs from the speed.
+         * @return uint16_t 
+         */
+        uint16_t getSteps();
+        /**
+         * @brief Get the duration of transitions between effects
+         * @return uint16_t Milliseconds
+         */
+        uint16_t getTransitionTime();
+        /**
+         * @brief Check whether a transition between effects is running
+         * @return true The previous effect is being faded out
+         */
+        bool inTransition();
+        /**
+         * @brief Get the RAM used for transitions between effects: the buffer and the state of the outgoing effect
+         * @return size_t Bytes
+         */
+        size_t getTransitionRAM();
+        /**
+         * @brief Get the current budget
+         * @return uint16_t mA, 0 if there is no limit
+         */
+        uint16_t getPowerBudget();
+        /**
+         * @brief Get the estimated current drawn by the LEDs at the brightness they are shown at.
+         * Only kept up to date while a budget is set.
+         * @return uint16_t mA
+         */
+        uint16_t getPowerDraw();
+        /**
+         * @brief Get the color correction
+         * @return const ColorCorrection* NULL if colors are drawn uncorrected
+         */
+        const ColorCorrection* getCorrection();
+        /**
+         * @brief Get whether levels lost to brightness scaling are dithered
+         * @return true Frames are sent every frame period while the brightness is below 255
+         */
+        bool getDither();
         
         /**
          * @brief Get the Current Color Index (minimum)
@@ -199,6 +679,82 @@ namespace LEDStripController
          * @return int 
          */
         int getColorIndexOffset();
+        /**
+         * @brief Get the EEPROM commit delay
+         * @return unsigned long Delay in milliseconds
+         */
+        unsigned long getCommitDelay();
+        /**
+         * @brief Check for settings not yet written to EEPROM
+         * @return true There are uncommitted changes
+         */
+        bool hasUnsavedChanges();
+        /**
+         * @brief Get the settings store, e.g. to find the EEPROM region it uses
+         * @return SettingsStore& 
+         */
+        SettingsStore& getStore();
+        /**
+         * @brief Get the keep-alive interval
+         * @return unsigned long Interval in milliseconds, 0 if disabled
+         */
+        unsigned long getRefreshInterval();
+        /**
+         * @brief Get the number of FastLED.show() calls skipped because the frame had not changed
+         * @return unsigned long 
+         */
+        unsigned long getSkippedShows();
+        /**
+         * @brief Get the number of frames drawn
+         * @return unsigned long 
+         */
+        unsigned long getFrames();
+        /**
+         * @brief Get whether effects are paused
+         * @return true No frames are drawn by mainloop
+         */
+        bool getPaused();
+        /**
+         * @brief Check whether a batch is open
+         * @return true Changes are held back until commitBatch
+         */
+        bool inBatch();
+        /**
+         * @brief Get the state of the current lighting effect
+         * @return EffectState& 
+         */
+        EffectState& getState();
+        /**
+         * @brief Get a segment.
+         * Segment 0 is this Controller (the whole strip), added segments are numbered from 1.
+         * @param idx Segment number
+         * @return Controller* NULL if there is no such segment
+         */
+        Controller* getSegment(uint8_t idx);
+        /**
+         * @brief Get the number of segments, including segment 0 (this Controller)
+         * @return uint8_t 
+         */
+        uint8_t getNumSegments();
+        /**
+         * @brief Get the index of a segment's first LED
+         * @param idx Segment number
+         * @return int 0 for segment 0, or a segment that does not exist
+         */
+        int getSegmentStart(uint8_t idx);
+        /**
+         * @brief Check whether this Controller is drawn as a segment of another
+         * @return true Its frames are drawn and shown by its owner
+         */
+        bool isSegment();
+#if LEDCON_STATS
+        /**
+         * @brief Get the frame timing counters, only built with LEDCON_STATS (see FrameStats.h).
+         * Call reset on them to start counting again.
+         * @return FrameStats& 
+         */
+        FrameStats& getStats();
+#endif
 
         #pragma endregion
 
@@ -206,9 +762,43 @@ namespace LEDStripController
         
         /**
          * Main loop method of controller
-         * Reads serial for commands, and draws a frame to the LEDs
+         * Draws a frame to the LEDs when one is due at the current fps, otherwise returns straight away.
+         * Changed settings are written to EEPROM once the commit delay has passed.
+         * Call it as often as possible, other work can be done between calls.
+         * @return true A frame was drawn
+         */
+        bool mainloop();
+
+        /**
+         * @brief Check whether the next frame is due.
+         * A setting change makes the next frame due immediately, so it is shown without waiting a frame period.
+         */
+        bool frameDue();
+
+        /**
+         * @brief Get the time until the next frame is due
+         * @return unsigned long Microseconds, 0 if a frame is due
          */
-        void mainloop();
+        unsigned long timeUntilFrame();
+
+        /**
+         * @brief Get the time the next frame is due
+         * @return unsigned long micros() time
+         */
+        unsigned long getNextFrame();
+
+        /**
+         * Send the LEDs to the strip now.
+         * With an output (see setLEDs) only that output is sent, at this Controller's brightness.
+         * Otherwise FastLED.show() sends every output at FastLED's brightness.
+         * A segment shows the strip it is drawn on.
+         */
+        void show();
+        /**
+         * Send LEDs written from outside the effects (e.g. by PixelStream) to the strip now.
+         * The power estimate is measured again first, so the power budget also limits these frames.
+         */
+        void showWritten();
 
         /**
          * Advance the current color
@@ -216,10 +806,90 @@ namespace LEDStripController
          */
         void advanceColor();
 
+        /**
+         * Write any changed settings to EEPROM immediately
+         */
+        void save();
+
+        /**
+         * Start a batch of changes.
+         * Until commitBatch or abortBatch, no frames are drawn and nothing is written to EEPROM,
+         * so a scene made of several changes appears in one frame and is committed once.
+         */
+        void beginBatch();
+
+        /**
+         * Finish the open batch, all its changes are shown on the next mainloop call.
+         * If failBatch was called the changes are undone instead.
+         * @return true The batch was applied
+         */
+        bool commitBatch();
+
+        /**
+         * Mark the open batch as invalid, e.g. because one of its commands was rejected.
+         * commitBatch will then undo it, so none of its changes are applied.
+         */
+        void failBatch();
+
+        /**
+         * Undo every change made since beginBatch
+         */
+        void abortBatch();
+
+        /**
+         * Report that the LEDs have changed this frame, so the frame must be shown.
+         * Only needed by effects with the EffectFlags::tracksChanges flag.
+         */
+        void markDirty();
+
+        /**
+         * Apply the color correction (see setCorrection) to a color about to be drawn.
+         * Used by the base lighting functions, effects drawing to the LEDs directly should draw corrected colors.
+         * @param col Color as set
+         * @return CRGB Color to draw
+         */
+        CRGB correct(const CRGB &col);
+
+        /**
+         * Update the power estimate for LEDs about to be filled with a color, must be called before they are drawn.
+         * Called by the base effect functions, does nothing without a budget.
+         * @param first Index of the first LED
+         * @param count Number of LEDs
+         * @param col Color they will be filled with
+         */
+        void noteFill(int first, int count, const CRGB &col);
+
+        /**
+         * Request a full redraw on the next frame, e.g. after writing to the LEDs from outside an effect.
+         */
+        void redraw();
+
+        /**
+         * Check whether effects must redraw the whole frame.
+         * True on the first frame of an effect, and after the LEDs, settings or current color change.
+         */
+        bool needsRedraw();
+
+        /**
+         * Add a segment: another Controller drawn over a range of this one's LEDs, in the same frame and FastLED.show().
+         * The segment keeps its own effect, colors, brightness, speed, state and settings store,
+         * its brightness is relative to this Controller's, and its fps is not used.
+         * Segments are drawn in the order they are added and should not overlap.
+         * Turning this Controller off turns its segments off too.
+         * Only call mainloop on this Controller, it also commits the segments' settings.
+         * Segments cannot be added to a Controller drawing to an IndexedFrame.
+         * @param segment Controller to draw, must outlive this one and not have segments of its own
+         * @param start Index of the first LED
+         * @param length Number of LEDs
+         * @return int Segment number (from 1), -1 if it could not be added
+         */
+        int addSegment(Controller &segment, int start, int length);
+
         #pragma endregion
     };
 };
 
 #include "SerialController.h"
+#include "StripManager.h"
 
 #endif
@@ -0,0 +1,140 @@
+#include "PixelStream.h"
+#include "LEDStripController.h"
+
+namespace LEDStripController {
+    namespace {
+        const uint8_t adalightHeader[] = { 'A', 'd', 'a' };
+        const uint8_t tpm2Start = 0xC9;
+        const uint8_t tpm2Data = 0xDA;
+        const uint8_t tpm2End = 0x36;
+    };
+
+    #pragma region Constructors
+
+    PixelStream::PixelStream(Controller *parent, Stream *serial)
+    {
+        _parent = parent;
+        _serial = serial;
+        _active = false;
+        _timeout = defaultTimeout;
+        _lastByte = 0;
+        _frames = 0;
+        _headerPos = 0;
+        _tpm2 = false;
+        _pos = 0;
+        _length = 0;
+        _inFrame = false;
+    }
+
+    #pragma endregion
+
+    #pragma region Setters
+
+    void PixelStream::setActive(bool val) {
+        _active = val;
+        _headerPos = 0;
+        _inFrame = false;
+        _lastByte = millis();
+        if (!val) _parent->setPaused(false);
+    }
+
+    void PixelStream::setTimeout(unsigned long ms) {
+        _timeout = ms;
+    }
+
+    #pragma endregion
+
+    #pragma region Getters
+
+    bool PixelStream::isActive() {
+        return _active;
+    }
+
+    unsigned long PixelStream::getTimeout() {
+        return _timeout;
+    }
+
+    unsigned long PixelStream::getFrames() {
+        return _frames;
+    }
+
+    #pragma endregion
+
+    #pragma region Frame handling
+
+    void PixelStream::read()
+    {
+        if (!_active) return;
+
+        int available = _serial->available();
+        if (available <= 0) {
+            if (millis() - _lastByte > _timeout) setActive(false);
+            return;
+        }
+        _lastByte = millis();
+
+        // Nothing is written if the LEDs were changed to an IndexedFrame while streaming
+        uint8_t *leds = (uint8_t*)_parent->getLEDs();
+        uint16_t ledBytes = leds ? _parent->getNumLEDs() * sizeof(CRGB) : 0;
+
+        while (available-- > 0) {
+            uint8_t b = _serial->read();
+
+            if (!_inFrame) {
+                matchHeader(b);
+                continue;
+            }
+
+            if (_pos < _length) {
+                // Written as received, there is no frame buffer
+                if (_pos < ledBytes) leds[_pos] = b;
+                _pos++;
+                if (_pos == _length && !_tpm2) endFrame();
+            } else {
+                // TPM2 end byte, a frame without one is dropped
+                if (b == tpm2End) endFrame();
+                else _inFrame = false;
+            }
+        }
+    }
+
+    void PixelStream::matchHeader(uint8_t b)
+    {
+        // A byte that does not fit the current header may start a new one
+        if (_headerPos == 0 || (!_tpm2 && _headerPos < 3 && b != adalightHeader[_headerPos]) || (_tpm2 && _headerPos == 1 && b != tpm2Data)) {
+            _headerPos = 0;
+            if (b == adalightHeader[0]) _tpm2 = false;
+            else if (b == tpm2Start) _tpm2 = true;
+            else return;
+        }
+        _header[_headerPos++] = b;
+
+        if (_tpm2 && _headerPos == 4) {
+            _headerPos = 0;
+            startFrame(((uint16_t)_header[2] << 8) | _header[3]);
+        } else if (!_tpm2 && _headerPos == 6) {
+            _headerPos = 0;
+            if ((_header[3] ^ _header[4] ^ 0x55) != _header[5]) return;
+            startFrame((((uint16_t)_header[3] << 8 | _header[4]) + 1) * sizeof(CRGB));
+        }
+    }
+
+    void PixelStream::startFrame(uint16_t length)
+    {
+        // Effects stop drawing once a host is sending frames
+        _parent->setPaused(true);
+        _length = length;
+        _pos = 0;
+        _inFrame = true;
+        if (_length == 0 && !_tpm2) endFrame();
+    }
+
+    void PixelStream::endFrame()
+    {
+        _inFrame = false;
+        _frames++;
+        _parent->showWritten();
+    }
+
+    #pragma endregion
+};
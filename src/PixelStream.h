@@ -0,0 +1,93 @@
+#ifndef LEDCON_PixelStream_h
+#define LEDCON_PixelStream_h
+
+#include <Arduino.h>
+
+namespace LEDStripController
+{
+    class Controller;
+
+    /**
+     * Receiver for raw pixel frames rendered by the host.
+     *
+     * Two frame formats are recognised:
+     * Adalight: ['A'] ['d'] ['a'] [LED count - 1 (2 bytes, high first)] [high ^ low ^ 0x55] [r, g, b per LED]
+     * TPM2:     [0xC9] [0xDA] [data length (2 bytes, high first)] [r, g, b per LED] [0x36]
+     *
+     * Pixel bytes are copied straight into the Controller's LEDs as they arrive, bytes past the end of the strip are dropped.
+     * The Controller is paused while frames are streamed and each complete frame is shown immediately.
+     * If no byte arrives for the timeout, streaming stops and the Controller goes back to its effect.
+     */
+    class PixelStream
+    {
+    public:
+        static const unsigned long defaultTimeout = 1000;
+
+    private:
+        Controller *_parent;
+        Stream *_serial;
+        bool _active;
+        unsigned long _timeout;
+        unsigned long _lastByte;
+        unsigned long _frames;
+
+        // Header bytes matched so far, and the format they belong to
+        uint8_t _header[6];
+        uint8_t _headerPos;
+        bool _tpm2;
+
+        // Pixel bytes written into the current frame, and the frame length
+        uint16_t _pos;
+        uint16_t _length;
+        bool _inFrame;
+
+        /**
+         * @brief Match a byte against the frame headers, starting a frame when one is complete
+         */
+        void matchHeader(uint8_t b);
+        /**
+         * @brief Start copying pixel bytes into the LEDs
+         */
+        void startFrame(uint16_t length);
+        /**
+         * @brief Show the received frame
+         */
+        void endFrame();
+
+    public:
+        /**
+         * @brief Construct a new pixel stream receiver, inactive until setActive is called
+         * @param parent Controller whose LEDs frames are written to
+         * @param serial Stream frames are received through
+         */
+        PixelStream(Controller *parent, Stream *serial);
+
+        /**
+         * @brief Process all available bytes, and stop streaming once the timeout has passed
+         */
+        void read();
+
+        /**
+         * @brief Set whether the stream is read as pixel frames.
+         * Stopping resumes the Controller's effect.
+         * @param val Desired value
+         */
+        void setActive(bool val);
+        bool isActive();
+
+        /**
+         * @brief Set how long to wait for data before going back to the effect
+         * @param ms Timeout in milliseconds
+         */
+        void setTimeout(unsigned long ms);
+        unsigned long getTimeout();
+
+        /**
+         * @brief Get the number of complete frames shown
+         * @return unsigned long
+         */
+        unsigned long getFrames();
+    };
+};
+
+#endif
@@ -0,0 +1,37 @@
+#include "ReplyBuffer.h"
+
+namespace LEDStripController {
+    #pragma region Constructors
+
+    ReplyBuffer::ReplyBuffer(Stream *serial)
+    {
+        _serial = serial;
+        _len = 0;
+    }
+
+    #pragma endregion
+
+    #pragma region Interaction functions
+
+    size_t ReplyBuffer::write(uint8_t c) {
+        if (_len == size) send();
+        _buffer[_len++] = c;
+        return 1;
+    }
+
+    size_t ReplyBuffer::write(const uint8_t *buffer, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            if (_len == size) send();
+            _buffer[_len++] = buffer[i];
+        }
+        return len;
+    }
+
+    void ReplyBuffer::send() {
+        if (_len == 0) return;
+        _serial->write(_buffer, _len);
+        _len = 0;
+    }
+
+    #pragma endregion
+};
@@ -0,0 +1,42 @@
+#ifndef LEDCON_ReplyBuffer_h
+#define LEDCON_ReplyBuffer_h
+
+#include <Arduino.h>
+
+namespace LEDStripController
+{
+    /**
+     * Collects the text printed for a command reply, so it leaves in a single write to the stream.
+     * Over a slow UART or a serial bridge that sends each write as its own packet (e.g. Bluetooth),
+     * a reply printed piece by piece costs a write (and a packet) per print call.
+     * Printing more than the buffer holds sends what is already buffered first.
+     */
+    class ReplyBuffer : public Print
+    {
+    public:
+        static const uint8_t size = 64;
+
+    private:
+        Stream *_serial;
+        uint8_t _buffer[size];
+        uint8_t _len;
+
+    public:
+        /**
+         * @brief Construct a new, empty reply buffer
+         * @param serial Stream replies are sent to
+         */
+        ReplyBuffer(Stream *serial);
+
+        size_t write(uint8_t c);
+        size_t write(const uint8_t *buffer, size_t len);
+        using Print::write;
+
+        /**
+         * @brief Send the buffered reply, if any, in one write
+         */
+        void send();
+    };
+};
+
+#endif
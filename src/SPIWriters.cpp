@@ -0,0 +1,35 @@
+#include "SPIWriters.h"
+
+namespace LEDStripController {
+    namespace SPIWriters {
+        void apa102(const CRGB *pixels, uint8_t count, int first, int numLEDs) {
+            if (first == 0) {
+                SPI.beginTransaction(SPISettings(clockHz, MSBFIRST, SPI_MODE0));
+                // Start frame
+                for (uint8_t i = 0; i < 4; i++) SPI.transfer(0x00);
+            }
+            for (uint8_t i = 0; i < count; i++) {
+                SPI.transfer(0xFF);
+                SPI.transfer(pixels[i].b);
+                SPI.transfer(pixels[i].g);
+                SPI.transfer(pixels[i].r);
+            }
+            if (first + count >= numLEDs) {
+                // Each LED delays the data by half a clock, so half a clock per LED is needed to push it to the last one.
+                // Zeros, so the first 4 bytes are also the reset frame SK9822 LEDs need to show the data now rather than next frame.
+                for (int i = 0; i < 4 + numLEDs / 16; i++) SPI.transfer(0x00);
+                SPI.endTransaction();
+            }
+        }
+
+        void ws2801(const CRGB *pixels, uint8_t count, int first, int numLEDs) {
+            if (first == 0) SPI.beginTransaction(SPISettings(clockHz, MSBFIRST, SPI_MODE0));
+            for (uint8_t i = 0; i < count; i++) {
+                SPI.transfer(pixels[i].r);
+                SPI.transfer(pixels[i].g);
+                SPI.transfer(pixels[i].b);
+            }
+            if (first + count >= numLEDs) SPI.endTransaction();
+        }
+    };
+};
@@ -0,0 +1,29 @@
+#ifndef LEDCON_SPIWriters_h
+#define LEDCON_SPIWriters_h
+
+#include <SPI.h>
+#include <FastLED.h>
+
+namespace LEDStripController
+{
+    /**
+     * IndexedFrame::PixelWriter implementations for clocked chipsets on the hardware SPI port (MOSI to data, SCK to clock).
+     * Call SPI.begin() in setup. A frame is sent in a single SPI transaction, opened by its first chunk and closed by its last.
+     */
+    namespace SPIWriters
+    {
+        // SPI clock, within what both chipsets accept over a few metres of wire
+        const uint32_t clockHz = 4000000;
+
+        /**
+         * @brief Send pixels to APA102 (DotStar) or SK9822 LEDs, at full global brightness in BGR order
+         */
+        void apa102(const CRGB *pixels, uint8_t count, int first, int numLEDs);
+        /**
+         * @brief Send pixels to WS2801 LEDs in RGB order, the LEDs latch once the clock has been idle for 500us
+         */
+        void ws2801(const CRGB *pixels, uint8_t count, int first, int numLEDs);
+    };
+};
+
+#endif
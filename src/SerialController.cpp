@@ -1,50 +1,116 @@
 #include "SerialController.h"
+#include "Effects.h"
 
 namespace LEDStripController {
     #pragma region Constructors/destructors
 
-    SerialController::SerialController(Stream *stream):
+    SerialController::SerialController(Stream *stream, uint16_t storeStart, uint16_t storeLength):
+        SerialController(Effects::all, sizeof Effects::all / sizeof Effects::all[0], stream, storeStart, storeLength) {}
+
+    SerialController::SerialController(const Effect *effects, uint8_t numEffects, Stream *stream, uint16_t storeStart, uint16_t storeLength):
         _commandHandler(this, stream, _commandBuffer, sizeof _commandBuffer),
-        Controller()
+        _binaryHandler(this, stream),
+        _pixelStream(this, stream),
+        _reply(stream),
+        Controller(effects, numEffects, storeStart, storeLength)
     {
-        // Setup command handler
-        _commandHandler.SetDefaultHandler(commandFuncs::unrecognised);
+        _strips = NULL;
+        _selectedStrip = 0;
+        _selected = 0;
+
+        // Commands are looked up by dispatch, nothing is registered with (or allocated for) the command handler
+        _commandHandler.SetDefaultHandler(commandFuncs::dispatch);
+    }
 
-        // Help is aliased to "?" and "help"
-        _commandHandler.AddCommand(new SerialCommand("?", commandFuncs::help));
-        _commandHandler.AddCommand(new SerialCommand("help", commandFuncs::help));
+    SerialController::SerialController(): SerialController(&Serial) {}
 
-        // Toggle is aliased to "toggle" and "t"
-        _commandHandler.AddCommand(new SerialCommand("toggle", commandFuncs::toggle));
-        _commandHandler.AddCommand(new SerialCommand("t", commandFuncs::toggle));
+    SerialController::~SerialController() {}
+
+    #pragma endregion
 
-        // Brightness is aliased to "bright" and "b"
-        _commandHandler.AddCommand(new SerialCommand("bright", commandFuncs::brightness));
-        _commandHandler.AddCommand(new SerialCommand("b", commandFuncs::brightness));
+    #pragma region Setters/Getters
 
-        // Effect is aliased to "effect" and "e"
-        _commandHandler.AddCommand(new SerialCommand("effect", commandFuncs::effect));
-        _commandHandler.AddCommand(new SerialCommand("e", commandFuncs::effect));
+    void SerialController::setBinaryMode(bool val) {
+        _binaryHandler.setActive(val);
+    }
 
-        // Color is aliased to "color" and "c"
-        _commandHandler.AddCommand(new SerialCommand("col", commandFuncs::editColor));
-        _commandHandler.AddCommand(new SerialCommand("c", commandFuncs::editColor));
+    bool SerialController::getBinaryMode() {
+        return _binaryHandler.isActive();
+    }
 
-        // Current color is aliased to "mincolor" and "mic"
-        _commandHandler.AddCommand(new SerialCommand("mincolor", commandFuncs::minColor));
-        _commandHandler.AddCommand(new SerialCommand("mic", commandFuncs::minColor));
+    void SerialController::setStreamMode(bool val) {
+        _pixelStream.setActive(val && !getFrame());
+    }
 
-        // Final color is aliased to "maxcolor" and "mac"
-        _commandHandler.AddCommand(new SerialCommand("maxcolor", commandFuncs::maxColor));
-        _commandHandler.AddCommand(new SerialCommand("mac", commandFuncs::maxColor));
+    bool SerialController::getStreamMode() {
+        return _pixelStream.isActive();
+    }
 
-        // FPS is not aliased as it can't be shortened further
-        _commandHandler.AddCommand(new SerialCommand("fps", commandFuncs::fps));
+    PixelStream& SerialController::getPixelStream() {
+        return _pixelStream;
     }
 
-    SerialController::SerialController(): SerialController(&Serial) {}
+    ReplyBuffer& SerialController::getReply() {
+        return _reply;
+    }
 
-    SerialController::~SerialController() {}
+    void SerialController::setStripManager(StripManager *strips) {
+        _strips = strips;
+        _selectedStrip = 0;
+        _selected = 0;
+    }
+
+    StripManager* SerialController::getStripManager() {
+        return _strips;
+    }
+
+    bool SerialController::selectStrip(uint8_t idx) {
+        if (idx >= (_strips ? _strips->getNumStrips() : 1)) return false;
+        _selectedStrip = idx;
+        _selected = 0;
+        return true;
+    }
+
+    uint8_t SerialController::getSelectedStrip() {
+        return _selectedStrip;
+    }
+
+    Controller* SerialController::getStrip() {
+        return _strips ? _strips->getStrip(_selectedStrip) : this;
+    }
+
+    bool SerialController::selectSegment(uint8_t idx) {
+        if (idx >= getStrip()->getNumSegments()) return false;
+        _selected = idx;
+        return true;
+    }
+
+    uint8_t SerialController::getSelectedSegment() {
+        return _selected;
+    }
+
+    Controller* SerialController::getSelected() {
+        return getStrip()->getSegment(_selected);
+    }
+
+    void SerialController::beginCommandBatch() {
+        if (_strips) _strips->beginBatch();
+        else beginBatch();
+    }
+
+    bool SerialController::commitCommandBatch() {
+        return _strips ? _strips->commitBatch() : commitBatch();
+    }
+
+    void SerialController::failCommandBatch() {
+        if (_strips) _strips->failBatch();
+        else failBatch();
+    }
+
+    void SerialController::abortCommandBatch() {
+        if (_strips) _strips->abortBatch();
+        else abortBatch();
+    }
 
     #pragma endregion
 
@@ -58,174 +124,448 @@ namespace LEDStripController {
         return ((ControllerSerialCommands*) sender)->getParent();
     }
 
-    void commandFuncs::unrecognised(SerialCommands *sender, const char *cmd) 
+    /**
+     * Utility function used to get the segment selected with the "seg" command.
+     */
+    Controller* getSelected(SerialCommands *sender)
     {
-        sender->GetSerial()->print("ERROR: '");
-        sender->GetSerial()->print(cmd);
-        sender->GetSerial()->println("' IS NOT RECOGNISED");
+        // Only SerialController creates command handlers
+        return ((SerialController*) getController(sender))->getSelected();
     }
 
-    void commandFuncs::fps(SerialCommands *sender)
+    /**
+     * Utility function used to get the strip selected with the "strip" command.
+     */
+    Controller* getStrip(SerialCommands *sender)
     {
-        char *input = sender->Next();
+        return ((SerialController*) getController(sender))->getStrip();
+    }
 
-        // Set new value if provided
-        if (strlen(input) != 0) {
-            uint8_t val = atoi(input);
+    /**
+     * Utility function used to get the buffer replies are printed to, sent in one write once the commands have been read.
+     */
+    Print* reply(SerialCommands *sender)
+    {
+        return &((SerialController*) getController(sender))->getReply();
+    }
 
-            // Make sure value is in range
-            if (val < 1 || val > 255) {
-                sender->GetSerial()->println("ERROR: Value must be in range 1-255");
-                return;
+    /**
+     * Utility function used to print a color as "r, g, b", ending the line.
+     */
+    void printColor(Print *out, const CRGB &col)
+    {
+        out->print(col.r);
+        out->print(", ");
+        out->print(col.g);
+        out->print(", ");
+        out->println(col.b);
+    }
+
+    /**
+     * Utility function used to acknowledge a command.
+     * Inside a batch only the commit is acknowledged.
+     */
+    void replyOK(SerialCommands *sender, const char *msg = "OK")
+    {
+        if (!getController(sender)->inBatch()) reply(sender)->println(msg);
+    }
+
+    /**
+     * Utility function used to start an error reply, this also rejects any open batch.
+     * Returns the reply so the rest of the message can be printed.
+     */
+    Print* replyError(SerialCommands *sender)
+    {
+        ((SerialController*) getController(sender))->failCommandBatch();
+        reply(sender)->print("ERROR: ");
+        return reply(sender);
+    }
+
+    /**
+     * Utility function used to hash a command name.
+     * Evaluated at compile time for the names in findCommand, and at run time for received names.
+     */
+    constexpr uint16_t commandHash(const char *name, uint16_t hash = 5381)
+    {
+        return *name ? commandHash(name + 1, (uint16_t)((hash << 5) + hash) ^ (uint8_t)*name) : hash;
+    }
+
+    /**
+     * Utility function used to confirm a name found by its hash, as unknown names can share a hash with a command.
+     */
+    CommandHandler named(const char *name, const char *command, CommandHandler handler)
+    {
+        return strcmp(name, command) == 0 ? handler : NULL;
+    }
+
+    /**
+     * Utility function used to find the handler of a command name or alias.
+     * Names are hashed at compile time into the cases of a switch, so lookup takes the same time however many
+     * commands there are, and two names with the same hash fail to compile as duplicate cases.
+     * Returns NULL for unknown names.
+     */
+    CommandHandler findCommand(const char *name)
+    {
+        switch (commandHash(name))
+        {
+        case commandHash("?"): return named(name, "?", commandFuncs::help);
+        case commandHash("help"): return named(name, "help", commandFuncs::help);
+        case commandHash("toggle"): return named(name, "toggle", commandFuncs::toggle);
+        case commandHash("t"): return named(name, "t", commandFuncs::toggle);
+        case commandHash("bright"): return named(name, "bright", commandFuncs::brightness);
+        case commandHash("b"): return named(name, "b", commandFuncs::brightness);
+        case commandHash("effect"): return named(name, "effect", commandFuncs::effect);
+        case commandHash("e"): return named(name, "e", commandFuncs::effect);
+        case commandHash("col"): return named(name, "col", commandFuncs::editColor);
+        case commandHash("c"): return named(name, "c", commandFuncs::editColor);
+        case commandHash("mincolor"): return named(name, "mincolor", commandFuncs::minColor);
+        case commandHash("mic"): return named(name, "mic", commandFuncs::minColor);
+        case commandHash("maxcolor"): return named(name, "maxcolor", commandFuncs::maxColor);
+        case commandHash("mac"): return named(name, "mac", commandFuncs::maxColor);
+        case commandHash("fps"): return named(name, "fps", commandFuncs::fps);
+        case commandHash("speed"): return named(name, "speed", commandFuncs::speed);
+        case commandHash("sp"): return named(name, "sp", commandFuncs::speed);
+        case commandHash("fade"): return named(name, "fade", commandFuncs::transition);
+        case commandHash("fd"): return named(name, "fd", commandFuncs::transition);
+        case commandHash("power"): return named(name, "power", commandFuncs::power);
+        case commandHash("pw"): return named(name, "pw", commandFuncs::power);
+        case commandHash("dither"): return named(name, "dither", commandFuncs::dither);
+        case commandHash("di"): return named(name, "di", commandFuncs::dither);
+        case commandHash("save"): return named(name, "save", commandFuncs::save);
+        case commandHash("s"): return named(name, "s", commandFuncs::save);
+        case commandHash("binary"): return named(name, "binary", commandFuncs::binary);
+        case commandHash("bin"): return named(name, "bin", commandFuncs::binary);
+        case commandHash("begin"): return named(name, "begin", commandFuncs::begin);
+        case commandHash("commit"): return named(name, "commit", commandFuncs::commit);
+        case commandHash("abort"): return named(name, "abort", commandFuncs::abort);
+        case commandHash("segment"): return named(name, "segment", commandFuncs::segment);
+        case commandHash("seg"): return named(name, "seg", commandFuncs::segment);
+        case commandHash("strip"): return named(name, "strip", commandFuncs::strip);
+        // Stream is not aliased so a stray "s" cannot start it
+        case commandHash("stream"): return named(name, "stream", commandFuncs::stream);
+#if LEDCON_STATS
+        case commandHash("stats"): return named(name, "stats", commandFuncs::stats);
+#endif
+        default: return NULL;
+        }
+    }
+
+    /**
+     * Utility function used to read the arguments of a command in one pass.
+     * Each token is split in place in the command buffer, and parsed as a whole number as it is read.
+     * Returns false if an argument is not a whole number.
+     */
+    bool parseArgs(SerialCommands *sender, CommandArgs &args)
+    {
+        args.count = 0;
+        for (char *token = sender->Next(); token != NULL; token = sender->Next()) {
+            const char *c = token;
+            bool negative = *c == '-';
+            if (negative || *c == '+') c++;
+            if (*c == 0) return false;
+
+            // Saturates rather than overflowing, so huge values still fail range checks
+            long val = 0;
+            for (; *c; c++) {
+                if (*c < '0' || *c > '9') return false;
+                if (val < 100000000L) val = val * 10 + (*c - '0');
             }
-            getController(sender)->setFPS(val);
-            sender->GetSerial()->println("OK");
+
+            if (args.count < CommandArgs::max) args.values[args.count] = negative ? -val : val;
+            if (args.count < 255) args.count++;
+        }
+        return true;
+    }
+
+    void commandFuncs::unrecognised(SerialCommands *sender, const char *cmd) 
+    {
+        replyError(sender)->print("'");
+        reply(sender)->print(cmd);
+        reply(sender)->println("' IS NOT RECOGNISED");
+    }
+
+    void commandFuncs::dispatch(SerialCommands *sender, const char *cmd)
+    {
+        CommandHandler handler = findCommand(cmd);
+        if (handler == NULL) {
+            unrecognised(sender, cmd);
+            return;
+        }
+
+        CommandArgs args;
+        if (!parseArgs(sender, args)) {
+            replyError(sender)->println("Arguments must be whole numbers");
             return;
         }
+        handler(sender, args);
+    }
 
+    void commandFuncs::fps(SerialCommands *sender, CommandArgs &args)
+    {
         // When no value specified, show current value
-        sender->GetSerial()->println(getController(sender)->getFPS());
+        if (args.count == 0) {
+            reply(sender)->println(getStrip(sender)->getFPS());
+            return;
+        }
+
+        // Make sure value is in range
+        if (args.values[0] < 1 || args.values[0] > 255) {
+            replyError(sender)->println("Value must be in range 1-255");
+            return;
+        }
+        getStrip(sender)->setFPS(args.values[0]);
+        replyOK(sender);
     }
 
-    void commandFuncs::brightness(SerialCommands *sender) 
+    void commandFuncs::speed(SerialCommands *sender, CommandArgs &args)
     {
-        char *input = sender->Next();
-        uint8_t newVal = atoi(input);
+        // When no value specified, show current value
+        if (args.count == 0) {
+            reply(sender)->println(getSelected(sender)->getSpeed());
+            return;
+        }
 
-        //Check value is valid
-        if (input == NULL || newVal > 255){
-            sender->GetSerial()->println(FastLED.getBrightness());
+        // Make sure value is in range
+        if (args.values[0] < 1 || args.values[0] > 255) {
+            replyError(sender)->println("Value must be in range 1-255");
+            return;
+        }
+        getSelected(sender)->setSpeed(args.values[0]);
+        replyOK(sender);
+    }
+
+    void commandFuncs::transition(SerialCommands *sender, CommandArgs &args)
+    {
+        // When no value specified, show current value
+        if (args.count == 0) {
+            reply(sender)->println(getSelected(sender)->getTransitionTime());
+            return;
+        }
+
+        // Make sure value is in range
+        if (args.values[0] < 0 || args.values[0] > 65535) {
+            replyError(sender)->println("Value must be in range 0-65535");
             return;
         }
-        getController(sender)->setBrightness(newVal);
-        sender->GetSerial()->println("OK");
+        getSelected(sender)->setTransitionTime(args.values[0]);
+        replyOK(sender);
     }
 
-    void commandFuncs::editColor(SerialCommands *sender)
+    void commandFuncs::power(SerialCommands *sender, CommandArgs &args)
     {
-        char *input1 = sender->Next();
-        char *input2 = sender->Next();
-        char *input3 = sender->Next();
-        char *input4 = sender->Next();
-        Controller* controller = getController(sender);
+        // When no value specified, show the budget and the current estimate
+        if (args.count == 0) {
+            reply(sender)->print(getStrip(sender)->getPowerBudget());
+            reply(sender)->print(" ");
+            reply(sender)->println(getStrip(sender)->getPowerDraw());
+            return;
+        }
 
-        // Get number of arguments provided
-        int numArgs = ((strlen(input1) > 0) + (strlen(input2) > 0) + (strlen (input3) > 0) + (strlen(input4) > 0));
+        // Make sure value is in range
+        if (args.values[0] < 0 || args.values[0] > 65535) {
+            replyError(sender)->println("Value must be in range 0-65535");
+            return;
+        }
+        getStrip(sender)->setPowerBudget(args.values[0]);
+        replyOK(sender);
+    }
 
-        // Define variables
-        uint8_t r, g, b, i;
+    void commandFuncs::dither(SerialCommands *sender, CommandArgs &args)
+    {
+        // When no value specified, show the current state
+        if (args.count == 0) {
+            reply(sender)->println(getStrip(sender)->getDither());
+            return;
+        }
+
+        // Make sure value is in range
+        if (args.values[0] < 0 || args.values[0] > 1) {
+            replyError(sender)->println("Value must be 0 or 1");
+            return;
+        }
+        getStrip(sender)->setDither(args.values[0]);
+        replyOK(sender);
+    }
+
+    void commandFuncs::segment(SerialCommands *sender, CommandArgs &args)
+    {
+        SerialController *c = (SerialController*) getController(sender);
+        long idx = args.count ? args.values[0] : 0;
 
-        
-        switch (numArgs)
+        switch (args.count)
+        {
+        case 0:
+            // If no arguments provided, return the selected segment and its range
+            idx = c->getSelectedSegment();
+            reply(sender)->print(idx);
+            reply(sender)->print(" ");
+            reply(sender)->print(c->getStrip()->getSegmentStart(idx));
+            reply(sender)->print(" ");
+            reply(sender)->println(c->getSelected()->getNumLEDs());
+            break;
+
+        case 1:
+            // If one argument provided, select the segment following commands apply to
+            if (idx < 0 || idx > 255 || !c->selectSegment(idx)) {
+                replyError(sender)->print("Segment must be in range 0 - ");
+                reply(sender)->println(c->getStrip()->getNumSegments() - 1);
+                break;
+            }
+            replyOK(sender);
+            break;
+
+        case 3:
+            // If three arguments provided, move the segment
+            if (idx < 1 || idx > 255 || !c->getStrip()->setSegmentRange(idx, args.values[1], args.values[2])) {
+                replyError(sender)->print("Segment must be in range 1 - ");
+                reply(sender)->println(c->getStrip()->getNumSegments() - 1);
+                break;
+            }
+            replyOK(sender);
+            break;
+
+        default:
+            replyError(sender)->println("Invalid number of arguments provided");
+            break;
+        }
+    }
+
+    void commandFuncs::strip(SerialCommands *sender, CommandArgs &args)
+    {
+        SerialController *c = (SerialController*) getController(sender);
+
+        // If no number provided, echo current value
+        if (args.count == 0) {
+            reply(sender)->println(c->getSelectedStrip());
+            return;
+        }
+
+        if (args.values[0] < 0 || args.values[0] > 255 || !c->selectStrip(args.values[0])) {
+            replyError(sender)->print("Strip must be in range 0 - ");
+            reply(sender)->println(c->getStripManager() ? c->getStripManager()->getNumStrips() - 1 : 0);
+            return;
+        }
+        replyOK(sender);
+    }
+
+    void commandFuncs::brightness(SerialCommands *sender, CommandArgs &args) 
+    {
+        // If no number provided, echo current value
+        if (args.count == 0) {
+            reply(sender)->println(getSelected(sender)->getBrightness());
+            return;
+        }
+
+        //Check value is valid
+        if (args.values[0] < 0 || args.values[0] > 255) {
+            replyError(sender)->println("Value must be in range 0-255");
+            return;
+        }
+        getSelected(sender)->setBrightness(args.values[0]);
+        replyOK(sender);
+    }
+
+    void commandFuncs::editColor(SerialCommands *sender, CommandArgs &args)
+    {
+        Controller* controller = getSelected(sender);
+        long *v = args.values;
+
+        // Check channel values when setting a color
+        if (args.count == 3 || args.count == 4) {
+            for (uint8_t i = 0; i < 3; i++) {
+                if (v[i] < 0 || v[i] > 255) {
+                    replyError(sender)->println("Value must be in range 0-255");
+                    return;
+                }
+            }
+        }
+
+        switch (args.count)
         {
         case 0:
             // If no arguments provided, return the current color
-            sender->GetSerial()->print(controller->getColor().r);
-            sender->GetSerial()->print(", ");
-            sender->GetSerial()->print(controller->getColor().g);
-            sender->GetSerial()->print(", ");
-            sender->GetSerial()->println(controller->getColor().b);
+            printColor(reply(sender), controller->getColor());
             break;
 
         case 1:
             // If one argument provided, return the color at the given position
-            i = atoi(input1);
-            sender->GetSerial()->print(controller->getColor(i).r);
-            sender->GetSerial()->print(", ");
-            sender->GetSerial()->print(controller->getColor(i).g);
-            sender->GetSerial()->print(", ");
-            sender->GetSerial()->println(controller->getColor(i).b);
+            printColor(reply(sender), controller->getColor(v[0]));
             break;
 
         case 3:
             // If three arguments provided, we change the current color
-            r = atoi(input1);
-            g = atoi(input2);
-            b = atoi(input3);
-
-            controller->setColor(r, g, b);
-            sender->GetSerial()->println("OK");
+            controller->setColor(v[0], v[1], v[2]);
+            replyOK(sender);
             break;
 
         case 4:
             // If four arguments provided, we change the color with the given index
-            r = atoi(input1);
-            g = atoi(input2);
-            b = atoi(input3);
-            i = atoi(input4);
-
             // Check index bounds
-            if (i < 0 || i >= maxColors) {
-                sender->GetSerial()->print("ERROR: Index must be in range 0 - ");
-                sender->GetSerial()->println(maxColors - 1);
+            if (v[3] < 0 || v[3] >= maxColors) {
+                replyError(sender)->print("Index must be in range 0 - ");
+                reply(sender)->println(maxColors - 1);
                 break;
             }
 
-            controller->setColor(r, g, b, i);
-            sender->GetSerial()->println("OK");
+            controller->setColor(v[0], v[1], v[2], v[3]);
+            replyOK(sender);
             break;
 
         default:
-            sender->GetSerial()->println("ERROR: Invalid number of arguments provided");
+            replyError(sender)->println("Invalid number of arguments provided");
             break;
         }
     }
 
-    void commandFuncs::minColor(SerialCommands *sender) 
+    void commandFuncs::minColor(SerialCommands *sender, CommandArgs &args) 
     {
-        char *input = sender->Next();
-        char newVal = atoi(input);
-
         // If no number provided, echo current value
-        if (strlen(input) == 0) {
-            sender->GetSerial()->println(getController(sender)->getMinimumColorIndex());
+        if (args.count == 0) {
+            reply(sender)->println(getSelected(sender)->getMinimumColorIndex());
             return;
         }
 
         // Check given value in range
-        if (newVal < 0 || newVal >= maxColors) {
-            sender->GetSerial()->print("ERROR: Index must be in range 0 - ");
-            sender->GetSerial()->println(maxColors - 1);
+        if (args.values[0] < 0 || args.values[0] >= maxColors) {
+            replyError(sender)->print("Index must be in range 0 - ");
+            reply(sender)->println(maxColors - 1);
             return;
         }
 
         // Update value
-        getController(sender)->setMinimumColorIndex(newVal);
+        getSelected(sender)->setMinimumColorIndex(args.values[0]);
         // Reset current offset to prevent any out of range errors
-        getController(sender)->setColorIndexOffset(0);
-        sender->GetSerial()->println("OK");
+        getSelected(sender)->setColorIndexOffset(0);
+        replyOK(sender);
     }
 
-    void commandFuncs::effect(SerialCommands *sender) 
+    void commandFuncs::effect(SerialCommands *sender, CommandArgs &args) 
     {   
-        char *input = sender->Next();
-        int newVal = atoi(input);
-
         // If new value is null report current value
-        if (strlen(input) == 0) {
-            sender->GetSerial()->println(getController(sender)->getEffect());
+        if (args.count == 0) {
+            reply(sender)->println(getSelected(sender)->getEffect());
             return;
         }
 
-        // If new value is out of range, display error
-        if (!(newVal <= getController(sender)->effects.size() - 1 && newVal >= 0)) {
-            sender->GetSerial()->print("ERROR: Effect must be in range 0 - ");
-            sender->GetSerial()->println(getController(sender)->effects.size() - 1);
+        // If new value is not in the effect table, display error
+        long newVal = args.values[0];
+        if (newVal < 0 || newVal > 255 || getSelected(sender)->findEffect(newVal) < 0) {
+            replyError(sender)->print("Effect ");
+            reply(sender)->print(newVal);
+            reply(sender)->println(" is not available");
             return;
         }
 
-        getController(sender)->setEffect(newVal);
-        sender->GetSerial()->println("OK");
+        getSelected(sender)->setEffect(newVal);
+        replyOK(sender);
     }
 
-    void commandFuncs::toggle(SerialCommands *sender)
+    void commandFuncs::toggle(SerialCommands *sender, CommandArgs &args)
     {
-        Controller* c = getController(sender);
-        char *arg = sender->Next();
+        Controller* c = getSelected(sender);
 
-        if (strlen(arg) > 0) {
-            int state = atoi(arg);
-            c->setEnabled((bool)state);
+        if (args.count > 0) {
+            c->setEnabled(args.values[0] != 0);
         } else {
             // Flip the state if no argument provided
             c->setEnabled(!c->getEnabled());
@@ -233,45 +573,164 @@ namespace LEDStripController {
 
         // Inform the user of current state
         if (c->getEnabled()) {
-            sender->GetSerial()->println("ON");
+            replyOK(sender, "ON");
             return;
         }
-        sender->GetSerial()->println("OFF");
+        replyOK(sender, "OFF");
     }
 
-    void commandFuncs::help(SerialCommands *sender) 
+    void commandFuncs::save(SerialCommands *sender, CommandArgs &args)
     {
-        sender->GetSerial()->println("https://github.com/randomman552/Led-Strip-Controller");
+        StripManager *strips = ((SerialController*) getController(sender))->getStripManager();
+        if (strips) strips->save();
+        else getController(sender)->save();
+        replyOK(sender);
     }
 
-    void commandFuncs::maxColor(SerialCommands *sender)
+    void commandFuncs::binary(SerialCommands *sender, CommandArgs &args)
     {
-        char *input = sender->Next();
-        int newVal = atoi(input);
+        // Only SerialController creates command handlers
+        reply(sender)->println("OK");
+        ((SerialController*) getController(sender))->setBinaryMode(true);
+    }
 
-        if (strlen(input) == 0) {
-            sender->GetSerial()->println(getController(sender)->getMaximumColorIndex());
+    void commandFuncs::stream(SerialCommands *sender, CommandArgs &args)
+    {
+        if (getController(sender)->getFrame()) {
+            replyError(sender)->println("Streaming needs CRGB LEDs");
             return;
         }
+        reply(sender)->println("OK");
+        ((SerialController*) getController(sender))->setStreamMode(true);
+    }
 
-        if (newVal < 0 || newVal >= maxColors) {
-            sender->GetSerial()->print("ERROR: Index must be in range 0 - ");
-            sender->GetSerial()->println(maxColors - 1);
+    void commandFuncs::begin(SerialCommands *sender, CommandArgs &args)
+    {
+        // Not acknowledged, the commit replies for the whole batch
+        if (getController(sender)->inBatch()) {
+            replyError(sender)->println("Batch already open");
             return;
         }
-        getController(sender)->setMaximumColorIndex(newVal);
-        getController(sender)->setColorIndexOffset(0);
-        sender->GetSerial()->println("OK");
+        ((SerialController*) getController(sender))->beginCommandBatch();
+    }
+
+    void commandFuncs::commit(SerialCommands *sender, CommandArgs &args)
+    {
+        SerialController *c = (SerialController*) getController(sender);
+        if (!c->inBatch()) {
+            replyError(sender)->println("No batch open");
+            return;
+        }
+        if (!c->commitCommandBatch()) {
+            replyError(sender)->println("Batch rejected, no changes applied");
+            return;
+        }
+        reply(sender)->println("OK");
+    }
+
+    void commandFuncs::abort(SerialCommands *sender, CommandArgs &args)
+    {
+        ((SerialController*) getController(sender))->abortCommandBatch();
+        reply(sender)->println("OK");
+    }
+
+#if LEDCON_STATS
+    /**
+     * Utility function used to print one line of stage timings: label, count, min, avg and max
+     */
+    void printStage(Print *serial, const char *label, int idx, StageTiming &stage)
+    {
+        serial->print(label);
+        if (idx >= 0) serial->print(idx);
+        serial->print(" ");
+        serial->print(stage.count);
+        serial->print(" ");
+        serial->print(stage.min);
+        serial->print(" ");
+        serial->print(stage.average());
+        serial->print(" ");
+        serial->println(stage.max);
+    }
+
+    void commandFuncs::stats(SerialCommands *sender, CommandArgs &args)
+    {
+        Print *serial = reply(sender);
+        Controller *c = getSelected(sender);
+        FrameStats &parse = getController(sender)->getStats();
+        FrameStats &stats = c->getStats();
+
+        // Timings in microseconds, render is listed per effect id
+        printStage(serial, "parse", -1, parse.parse);
+        printStage(serial, "show", -1, stats.show);
+        for (uint8_t e = 0; e < c->getNumEffects() && e < FrameStats::maxEffects; e++) {
+            if (stats.render[e].count) printStage(serial, "render ", c->getEffects()[e].id, stats.render[e]);
+        }
+        serial->print("frames ");
+        serial->print(stats.frames);
+        serial->print(" late ");
+        serial->print(stats.late);
+        serial->print(" dropped ");
+        serial->print(stats.dropped);
+        serial->print(" eeprom ");
+        serial->println(stats.eepromWrites);
+
+        parse.parse = StageTiming();
+        stats.reset();
+    }
+#endif
+
+    void commandFuncs::help(SerialCommands *sender, CommandArgs &args) 
+    {
+        reply(sender)->println("https://github.com/randomman552/Led-Strip-Controller");
+    }
+
+    void commandFuncs::maxColor(SerialCommands *sender, CommandArgs &args)
+    {
+        if (args.count == 0) {
+            reply(sender)->println(getSelected(sender)->getMaximumColorIndex());
+            return;
+        }
+
+        if (args.values[0] < 0 || args.values[0] >= maxColors) {
+            replyError(sender)->print("Index must be in range 0 - ");
+            reply(sender)->println(maxColors - 1);
+            return;
+        }
+        getSelected(sender)->setMaximumColorIndex(args.values[0]);
+        getSelected(sender)->setColorIndexOffset(0);
+        replyOK(sender);
     }
 
     #pragma endregion
 
     #pragma region Method overrides
 
-    void SerialController::mainloop()
+    void SerialController::readCommands()
+    {
+        // Text handling follows straight on if a binary frame switches back to text
+        if (_pixelStream.isActive()) {
+            _pixelStream.read();
+        } else {
+#if LEDCON_STATS
+            // Only timed when bytes are waiting, so idle calls do not hide the cost of a command
+            bool waiting = _commandHandler.GetSerial()->available() > 0;
+            unsigned long parseStart = micros();
+#endif
+            if (_binaryHandler.isActive()) _binaryHandler.read();
+            if (!_binaryHandler.isActive()) _commandHandler.ReadSerial();
+            // Everything printed by the commands leaves in one write
+            _reply.send();
+#if LEDCON_STATS
+            if (waiting) getStats().parse.add(micros() - parseStart);
+#endif
+        }
+    }
+
+    bool SerialController::mainloop()
     {
-        _commandHandler.ReadSerial();
-        Controller::mainloop();
+        // Commands are read on every call, not just when a frame is drawn
+        readCommands();
+        return Controller::mainloop();
     }
 
 #pragma endregion
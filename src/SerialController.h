@@ -3,6 +3,10 @@
 
 #include <SerialCommands.h>
 #include "LEDStripController.h"
+#include "BinaryCommands.h"
+#include "PixelStream.h"
+#include "ReplyBuffer.h"
+#include "StripManager.h"
 
 
 namespace LEDStripController {
@@ -24,17 +28,148 @@ namespace LEDStripController {
      * Subclass of Controller that takes arguments over a Serial stream,
      * Takes a stream as a constructor argument.
      * If none is provided, will default to the standard Serial stream.
+     * Commands are read as text lines, or as binary frames (see BinaryCommands) after the "binary" command.
+     * The "stream" command switches to raw pixel frames (see PixelStream) until the host stops sending.
      */
     class SerialController : public Controller {
     private:
         ControllerSerialCommands _commandHandler;
         char _commandBuffer[64];
+        BinaryCommands _binaryHandler;
+        PixelStream _pixelStream;
+        ReplyBuffer _reply;
+        // Strips the commands can address, see StripManager::setCommands
+        StripManager *_strips;
+        // Strip, and segment of it, the per-segment commands apply to
+        uint8_t _selectedStrip;
+        uint8_t _selected;
+    protected:
+        SerialController(const Effect *effects, uint8_t numEffects, Stream *stream, uint16_t storeStart, uint16_t storeLength);
     public:
-        SerialController(Stream *stream);
+        /**
+         * @brief Construct a new SerialController reading commands from the given stream
+         * @param stream Stream commands are received through
+         * @param storeStart First EEPROM address used to store settings
+         * @param storeLength Number of EEPROM bytes used to store settings
+         */
+        SerialController(Stream *stream, uint16_t storeStart = SettingsStore::defaultStart, uint16_t storeLength = SettingsStore::defaultLength);
         SerialController();
+        /**
+         * @brief Construct a new SerialController with a custom effect table
+         * @param effects Table of effects, must outlive the Controller
+         * @param stream Stream commands are received through
+         * @param storeStart First EEPROM address used to store settings
+         * @param storeLength Number of EEPROM bytes used to store settings
+         */
+        template<size_t N>
+        SerialController(const Effect (&effects)[N], Stream *stream = &Serial, uint16_t storeStart = SettingsStore::defaultStart, uint16_t storeLength = SettingsStore::defaultLength):
+            SerialController(effects, N, stream, storeStart, storeLength)
+        {
+            static_assert(N > 0 && N <= 255, "Effect table must hold 1-255 effects");
+        }
         ~SerialController();
 
-        void mainloop();
+        /**
+         * @brief Set whether commands are read as binary frames instead of text
+         * @param val Desired value
+         */
+        void setBinaryMode(bool val);
+        /**
+         * @brief Get whether commands are read as binary frames
+         * @return true Binary mode is active
+         */
+        bool getBinaryMode();
+
+        /**
+         * @brief Set whether the stream is read as raw pixel frames.
+         * Streaming stops by itself once no data has arrived for the PixelStream timeout,
+         * then commands are read in the previous mode again.
+         * Streamed pixels are written to the CRGB LEDs as received, so it cannot be started while the LEDs are an IndexedFrame.
+         * @param val Desired value
+         */
+        void setStreamMode(bool val);
+        /**
+         * @brief Get whether the stream is read as raw pixel frames
+         * @return true Stream mode is active
+         */
+        bool getStreamMode();
+        /**
+         * @brief Get the pixel frame receiver, e.g. to set its timeout
+         * @return PixelStream& 
+         */
+        PixelStream& getPixelStream();
+        /**
+         * @brief Get the buffer text command replies are printed to.
+         * It is sent in one write after the waiting commands have been read.
+         * @return ReplyBuffer& 
+         */
+        ReplyBuffer& getReply();
+
+        /**
+         * @brief Set the manager whose strips the "strip" command selects, called by StripManager::setCommands
+         * @param strips Manager, NULL to only address this Controller
+         */
+        void setStripManager(StripManager *strips);
+        /**
+         * @brief Get the manager whose strips the commands can address
+         * @return StripManager* NULL if there is none
+         */
+        StripManager* getStripManager();
+
+        /**
+         * @brief Select the strip the commands apply to, this also selects its segment 0
+         * @param idx Strip number in the StripManager, 0 without one
+         * @return true The strip exists
+         */
+        bool selectStrip(uint8_t idx);
+        /**
+         * @brief Get the number of the selected strip
+         * @return uint8_t 
+         */
+        uint8_t getSelectedStrip();
+        /**
+         * @brief Get the selected strip
+         * @return Controller* This Controller without a StripManager
+         */
+        Controller* getStrip();
+
+        /**
+         * @brief Select the segment of the selected strip that the effect, toggle, brightness, color, speed and fade commands apply to.
+         * Other commands (fps, segment ranges) apply to the whole strip.
+         * @param idx Segment number, 0 for the whole strip (see Controller::getSegment)
+         * @return true The segment exists
+         */
+        bool selectSegment(uint8_t idx);
+        /**
+         * @brief Get the number of the selected segment
+         * @return uint8_t 
+         */
+        uint8_t getSelectedSegment();
+        /**
+         * @brief Get the selected segment
+         * @return Controller* 
+         */
+        Controller* getSelected();
+
+        /**
+         * Batch functions used by the commands.
+         * With a StripManager the batch covers every strip, otherwise this Controller (see Controller::beginBatch).
+         */
+        void beginCommandBatch();
+        bool commitCommandBatch();
+        void failCommandBatch();
+        void abortCommandBatch();
+
+        /**
+         * Handle any received commands, without drawing a frame
+         */
+        void readCommands();
+
+        /**
+         * Handle any received commands, then run Controller::mainloop
+         * @return true A frame was drawn
+         */
+        bool mainloop();
     };
     
     /**
@@ -43,24 +178,47 @@ namespace LEDStripController {
      */
     namespace
     {
+        /**
+         * Arguments of a text command, split and parsed in place in one pass over the line.
+         * All commands take whole numbers.
+         */
+        struct CommandArgs
+        {
+            static const uint8_t max = 4;
+            // Number of arguments given, only the first max are kept in values
+            uint8_t count;
+            long values[max];
+        };
+
+        /**
+         * Command handler, found by name in a table built at compile time (see findCommand)
+         */
+        typedef void (*CommandHandler)(SerialCommands *sender, CommandArgs &args);
+
         namespace commandFuncs
         {
             /**
              * Unrecognised command handler
              */
             void unrecognised(SerialCommands *sender, const char *cmd);
+
+            /**
+             * Entry point for every received line, set as the SerialCommands default handler.
+             * Finds the command's handler and parses its arguments.
+             */
+            void dispatch(SerialCommands *sender, const char *cmd);
             
             /**
              * Command handler
-             * "effect/e <id(0-effects.size())>"
+             * "effect/e <id>"
              */
-            void effect(SerialCommands *sender);
+            void effect(SerialCommands *sender, CommandArgs &args);
         
             /**
              * Command handler
              * "toggle/t <state(1,0)>"
              */
-            void toggle(SerialCommands *sender);
+            void toggle(SerialCommands *sender, CommandArgs &args);
             
             /**
              * Command handler
@@ -69,37 +227,117 @@ namespace LEDStripController {
              * "color/c <r(0-255)> <g(0-255)> <b(0-255)>" - Set current color
              * "color/c <r(0-255)> <g(0-255)> <b(0-255)> <index(0-7)>" Set color with index
              */
-            void editColor(SerialCommands *sender);
+            void editColor(SerialCommands *sender, CommandArgs &args);
 
             /**
              * Command handler
              * "mincolor/mic <index(0-7)>"
              */
-            void minColor(SerialCommands *sender);
+            void minColor(SerialCommands *sender, CommandArgs &args);
 
             /**
              * Command handler
              * "maxcolor/mac <index(0-7)>"
              */
-            void maxColor(SerialCommands *sender);
+            void maxColor(SerialCommands *sender, CommandArgs &args);
 
             /**
              * Command handler
              * "bright/b <value(0-255)>"
              */
-            void brightness(SerialCommands *sender);
+            void brightness(SerialCommands *sender, CommandArgs &args);
 
             /**
              * Command handler
              * "fps <value(0-255>"
              */
-            void fps(SerialCommands *sender);
+            void fps(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "speed/sp <percent(1-255)>"
+             */
+            void speed(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "fade/fd <ms(0-65535)>" - Set the duration of transitions between effects, see Controller::setTransition
+             */
+            void transition(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "power/pw <mA(0-65535)>" - Set the power budget of the selected strip, see Controller::setPowerBudget
+             */
+            void power(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "dither/di <state(0-1)>" - Set temporal dithering of the selected strip, see Controller::setDither
+             */
+            void dither(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "seg <index> <start> <length>" - Select, move or resize a segment
+             */
+            void segment(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "strip <index>" - Select the strip the commands apply to, see StripManager
+             */
+            void strip(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "save/s"
+             */
+            void save(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "binary/bin" - Switch to binary frames, see BinaryCommands
+             */
+            void binary(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "stream" - Switch to raw pixel frames, see PixelStream
+             */
+            void stream(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "begin" - Start a batch, following commands are applied together by "commit"
+             */
+            void begin(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "commit" - Apply the open batch, or undo it if any command in it failed
+             */
+            void commit(SerialCommands *sender, CommandArgs &args);
+
+            /**
+             * Command handler
+             * "abort" - Undo the open batch
+             */
+            void abort(SerialCommands *sender, CommandArgs &args);
+
+#if LEDCON_STATS
+            /**
+             * Command handler
+             * "stats" - Print and reset the frame timings of the selected segment, see FrameStats
+             */
+            void stats(SerialCommands *sender, CommandArgs &args);
+#endif
             
             /**
              * Command handler
              * "help/?"
              */
-            void help(SerialCommands *sender);
+            void help(SerialCommands *sender, CommandArgs &args);
 
         }; // namespace commandFuncs
     }; // namespace
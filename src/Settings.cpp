@@ -0,0 +1,186 @@
+#include "Settings.h"
+
+namespace LEDStripController {
+    uint8_t crc8(const uint8_t *data, uint8_t len, uint8_t crc)
+    {
+        while (len--) {
+            crc ^= *data++;
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+            }
+        }
+        return crc;
+    }
+
+    namespace {
+        // Record layout, see SettingsStore
+        const uint8_t seqBytes = 3;
+        const uint8_t keyIdx = 3;
+        const uint8_t valueIdx = 4;
+        const uint8_t crcIdx = 7;
+        const uint8_t keyMask = 0x1F;
+        const uint8_t versionShift = 5;
+
+        /**
+         * Read a record and check it is valid for this settings version.
+         * Erased EEPROM (0xFF) is rejected by the version check.
+         */
+        bool readRecord(uint16_t addr, uint8_t *record)
+        {
+            for (uint8_t i = 0; i < SettingsStore::recordSize; i++) {
+                record[i] = EEPROM.read(addr + i);
+            }
+            if ((record[keyIdx] >> versionShift) != (version & 0x07)) return false;
+            if ((record[keyIdx] & keyMask) >= Keys::count) return false;
+            return crc8(record, crcIdx) == record[crcIdx];
+        }
+
+        uint32_t recordSeq(const uint8_t *record)
+        {
+            return (uint32_t)record[0] | ((uint32_t)record[1] << 8) | ((uint32_t)record[2] << 16);
+        }
+    };
+
+    #pragma region Constructors
+
+    SettingsStore::SettingsStore(uint16_t start, uint16_t length)
+    {
+        if (length < minLength) length = minLength;
+        if (length / recordSize > maxSlots) length = maxSlots * recordSize;
+
+        _start = start;
+        _slots = length / recordSize;
+        _head = _slots - 1;
+        _seq = 0;
+        for (uint8_t key = 0; key < Keys::count; key++) _liveSlot[key] = noSlot;
+    }
+
+    #pragma endregion
+
+    #pragma region Storage functions
+
+    uint8_t SettingsStore::load()
+    {
+        uint8_t record[recordSize];
+        uint32_t liveSeq[Keys::count];
+        uint8_t found = 0;
+        bool any = false;
+
+        for (uint8_t key = 0; key < Keys::count; key++) _liveSlot[key] = noSlot;
+
+        for (uint8_t slot = 0; slot < _slots; slot++) {
+            if (!readRecord(slotAddr(slot), record)) continue;
+
+            uint8_t key = record[keyIdx] & keyMask;
+            uint32_t seq = recordSeq(record);
+
+            if (_liveSlot[key] == noSlot) {
+                found++;
+            } else if (seq < liveSeq[key]) {
+                continue;
+            }
+            _liveSlot[key] = slot;
+            liveSeq[key] = seq;
+
+            // Continue writing after the newest record
+            if (!any || seq >= _seq) {
+                _seq = seq + 1;
+                _head = slot;
+                any = true;
+            }
+        }
+
+        if (!any) {
+            _seq = 0;
+            _head = _slots - 1;
+        }
+        return found;
+    }
+
+    bool SettingsStore::read(uint8_t key, uint8_t *value)
+    {
+        if (key >= Keys::count || _liveSlot[key] == noSlot) return false;
+
+        uint16_t addr = slotAddr(_liveSlot[key]) + valueIdx;
+        for (uint8_t i = 0; i < Keys::size(key); i++) {
+            value[i] = EEPROM.read(addr + i);
+        }
+        return true;
+    }
+
+    bool SettingsStore::write(uint8_t key, const uint8_t *value)
+    {
+        if (key >= Keys::count) return false;
+
+        uint8_t record[recordSize];
+        uint8_t size = Keys::size(key);
+
+        // Skip the write when the stored value already matches
+        if (_liveSlot[key] != noSlot) {
+            uint16_t addr = slotAddr(_liveSlot[key]) + valueIdx;
+            uint8_t i = 0;
+            while (i < size && EEPROM.read(addr + i) == value[i]) i++;
+            if (i == size) return false;
+        }
+
+        record[0] = _seq;
+        record[1] = _seq >> 8;
+        record[2] = _seq >> 16;
+        record[keyIdx] = ((version & 0x07) << versionShift) | key;
+        for (uint8_t i = 0; i < sizeof(CRGB); i++) {
+            record[valueIdx + i] = i < size ? value[i] : 0;
+        }
+        record[crcIdx] = crc8(record, crcIdx);
+
+        // Find the next slot not holding a live record.
+        // The old record for this key is also kept until the new one is complete.
+        uint8_t slot = _head;
+        do {
+            slot = (slot + 1 == _slots) ? 0 : slot + 1;
+        } while (isLive(slot));
+
+        // CRC is written last so an interrupted write leaves an invalid record
+        uint16_t addr = slotAddr(slot);
+        for (uint8_t i = 0; i < recordSize; i++) {
+            EEPROM.update(addr + i, record[i]);
+        }
+
+        _liveSlot[key] = slot;
+        _head = slot;
+        _seq++;
+        return true;
+    }
+
+    #pragma endregion
+
+    #pragma region Getters
+
+    uint16_t SettingsStore::start() {
+        return _start;
+    }
+
+    uint16_t SettingsStore::end() {
+        return _start + (uint16_t)_slots * recordSize;
+    }
+
+    uint8_t SettingsStore::slots() {
+        return _slots;
+    }
+
+    #pragma endregion
+
+    #pragma region Helpers
+
+    uint16_t SettingsStore::slotAddr(uint8_t slot) {
+        return _start + (uint16_t)slot * recordSize;
+    }
+
+    bool SettingsStore::isLive(uint8_t slot) {
+        for (uint8_t key = 0; key < Keys::count; key++) {
+            if (_liveSlot[key] == slot) return true;
+        }
+        return false;
+    }
+
+    #pragma endregion
+};
@@ -0,0 +1,159 @@
+#ifndef LEDCON_Settings_h
+#define LEDCON_Settings_h
+
+#include <EEPROM.h>
+#include <FastLED.h>
+
+namespace LEDStripController
+{
+    /**
+     * Settings record format version.
+     * Records written with a different version are ignored when loading.
+     */
+    const int version = 2;
+    const int maxColors = 8;
+
+    /**
+     * CRC-8 helper function (polynomial 0x07).
+     * data - Bytes to checksum
+     * len - Number of bytes
+     * crc - Initial value, pass a previous result to continue a checksum
+     */
+    uint8_t crc8(const uint8_t *data, uint8_t len, uint8_t crc = 0);
+
+    /**
+     * Namespace containing the setting keys.
+     * Each key is stored as its own record, colors take one key per color.
+     */
+    namespace Keys
+    {
+        const uint8_t effect = 0;
+        const uint8_t brightness = 1;
+        const uint8_t enabled = 2;
+        const uint8_t currentColorIdx = 3;
+        const uint8_t finalColorIdx = 4;
+        const uint8_t fps = 5;
+        const uint8_t colors = 6;
+        // Keys added after the colors, so earlier keys keep their numbers
+        const uint8_t speed = colors + maxColors;
+        const uint8_t count = speed + 1;
+
+        /**
+         * @brief Byte offset of a key's value within the Settings struct
+         */
+        inline uint8_t offset(uint8_t key) {
+            if (key < colors) return key;
+            if (key < speed) return colors + (key - colors) * sizeof(CRGB);
+            return colors + maxColors * sizeof(CRGB) + (key - speed);
+        }
+
+        /**
+         * @brief Size in bytes of a key's value
+         */
+        inline uint8_t size(uint8_t key) { return key >= colors && key < speed ? sizeof(CRGB) : 1; }
+    };
+
+    /**
+     * RAM copy of all settings.
+     * Field order matches the Keys namespace.
+     */
+    struct Settings
+    {
+        uint8_t effect;
+        uint8_t brightness;
+        uint8_t enabled;
+        uint8_t currentColorIdx;
+        uint8_t finalColorIdx;
+        uint8_t fps;
+        CRGB colors[maxColors];
+        uint8_t speed;
+    };
+    static_assert(sizeof(Settings) == Keys::colors + sizeof(CRGB) * maxColors + 1, "Settings layout must match Keys");
+    static_assert(Keys::count <= 16, "Settings dirty mask holds 16 keys");
+
+    /**
+     * Wear-levelled storage for settings in a region of EEPROM.
+     *
+     * The region is treated as a ring of fixed size records:
+     * [sequence (3 bytes)] [version << 5 | key] [value (3 bytes)] [CRC-8]
+     * Every change appends a record for one key at the next free slot, so writes are spread over the whole region.
+     * Slots holding the newest record of a key are skipped, every other slot is garbage and gets reused.
+     * Loading scans each slot once and keeps the newest valid record per key.
+     *
+     * Records are compared by a 24 bit sequence number, which must not wrap: loading would then prefer older records.
+     * Each slot is written about once per pass over the ring, so the region is limited to maxSlots slots, keeping
+     * slots times the rated write endurance of a cell below 2^24. No renumbering is then needed before the cells wear out.
+     */
+    class SettingsStore
+    {
+    private:
+        uint16_t _start;
+        uint8_t _slots;
+        // Slot holding the newest record for each key, noSlot if there is none
+        uint8_t _liveSlot[Keys::count];
+        // Slot of the most recently written record
+        uint8_t _head;
+        uint32_t _seq;
+
+        uint16_t slotAddr(uint8_t slot);
+        bool isLive(uint8_t slot);
+
+    public:
+        static const uint8_t recordSize = 8;
+        static const uint8_t noSlot = 0xFF;
+        static const uint16_t defaultStart = 0;
+        static const uint16_t defaultLength = 256;
+        // Smallest usable region, there must always be a free slot besides the newest record of every key
+        static const uint16_t minLength = (Keys::count + 2) * recordSize;
+        // Rated writes per EEPROM cell (AVR)
+        static const uint32_t endurance = 100000;
+        // Most slots the sequence number can number for the life of the region, 167 (1336 bytes)
+        static const uint8_t maxSlots = 0xFFFFFFUL / endurance;
+
+        /**
+         * @brief Create a store over the given EEPROM region. Call load before use.
+         * @param start First EEPROM address of the region
+         * @param length Length of the region in bytes (at least minLength, at most maxSlots records)
+         */
+        SettingsStore(uint16_t start = defaultStart, uint16_t length = defaultLength);
+
+        /**
+         * @brief Scan the region for the newest valid record of each key.
+         * Reads every slot once, so cost is bounded by the region length.
+         * @return uint8_t Number of keys found
+         */
+        uint8_t load();
+
+        /**
+         * @brief Read the stored value of a key
+         * @param key Key from the Keys namespace
+         * @param value Destination, Keys::size(key) bytes
+         * @return true Value was found
+         * @return false No record exists for this key
+         */
+        bool read(uint8_t key, uint8_t *value);
+
+        /**
+         * @brief Append a new record for a key. Does nothing if the stored value is unchanged.
+         * @param key Key from the Keys namespace
+         * @param value Keys::size(key) bytes
+         * @return true A record was written
+         */
+        bool write(uint8_t key, const uint8_t *value);
+
+        /**
+         * @brief Get the first EEPROM address used
+         */
+        uint16_t start();
+        /**
+         * @brief Get the address after the last EEPROM address used
+         */
+        uint16_t end();
+        /**
+         * @brief Get the number of record slots in the region
+         */
+        uint8_t slots();
+    };
+};
+
+#endif
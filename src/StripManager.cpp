@@ -0,0 +1,112 @@
+#include "StripManager.h"
+#include "LEDStripController.h"
+
+namespace LEDStripController {
+    #pragma region Constructors
+
+    StripManager::StripManager()
+    {
+        _numStrips = 0;
+        _commands = NULL;
+    }
+
+    #pragma endregion
+
+    #pragma region Setters
+
+    int StripManager::addStrip(Controller &strip) {
+        if (_numStrips >= maxStrips || strip.isSegment()) return -1;
+        _strips[_numStrips] = &strip;
+        return _numStrips++;
+    }
+
+    void StripManager::setCommands(SerialController &commands) {
+        // The commands' own Controller must take part in batches, so it is always one of the strips
+        bool found = false;
+        for (uint8_t s = 0; s < _numStrips; s++) found |= _strips[s] == &commands;
+        if (!found) addStrip(commands);
+
+        _commands = &commands;
+        commands.setStripManager(this);
+    }
+
+    #pragma endregion
+
+    #pragma region Getters
+
+    Controller* StripManager::getStrip(uint8_t idx) {
+        return idx < _numStrips ? _strips[idx] : NULL;
+    }
+
+    uint8_t StripManager::getNumStrips() {
+        return _numStrips;
+    }
+
+    #pragma endregion
+
+    #pragma region Interaction functions
+
+    bool StripManager::mainloop()
+    {
+        // Commands first, so a change is drawn in this pass
+        if (_commands) _commands->readCommands();
+
+        // Earliest deadline first: pick the strip whose frame has been due the longest.
+        // Paused strips and strips in a batch draw nothing, so they must not take the turn of another strip.
+        unsigned long now = micros();
+        int next = -1;
+        long waited = 0;
+        for (uint8_t s = 0; s < _numStrips; s++) {
+            Controller *strip = _strips[s];
+            if (strip->getPaused() || strip->inBatch() || !strip->frameDue()) continue;
+
+            long late = (long)(now - strip->getNextFrame());
+            if (next < 0 || late > waited) {
+                next = s;
+                waited = late;
+            }
+        }
+
+        // Strips whose frame is not due only commit settings, due strips that lost their turn wait for the next call
+        bool drawn = false;
+        for (uint8_t s = 0; s < _numStrips; s++) {
+            if (s == next) drawn = _strips[s]->mainloop();
+            else if (!_strips[s]->frameDue() || _strips[s]->getPaused() || _strips[s]->inBatch()) _strips[s]->mainloop();
+        }
+        return drawn;
+    }
+
+    unsigned long StripManager::timeUntilFrame() {
+        unsigned long soonest = 0;
+        for (uint8_t s = 0; s < _numStrips; s++) {
+            unsigned long wait = _strips[s]->timeUntilFrame();
+            if (s == 0 || wait < soonest) soonest = wait;
+        }
+        return soonest;
+    }
+
+    void StripManager::beginBatch() {
+        for (uint8_t s = 0; s < _numStrips; s++) _strips[s]->beginBatch();
+    }
+
+    bool StripManager::commitBatch() {
+        // Failures are marked on every strip, so they all commit or all roll back
+        bool applied = false;
+        for (uint8_t s = 0; s < _numStrips; s++) applied |= _strips[s]->commitBatch();
+        return applied;
+    }
+
+    void StripManager::failBatch() {
+        for (uint8_t s = 0; s < _numStrips; s++) _strips[s]->failBatch();
+    }
+
+    void StripManager::abortBatch() {
+        for (uint8_t s = 0; s < _numStrips; s++) _strips[s]->abortBatch();
+    }
+
+    void StripManager::save() {
+        for (uint8_t s = 0; s < _numStrips; s++) _strips[s]->save();
+    }
+
+    #pragma endregion
+};
@@ -0,0 +1,104 @@
+#ifndef LEDCON_StripManager_h
+#define LEDCON_StripManager_h
+
+#include <Arduino.h>
+
+namespace LEDStripController
+{
+    class Controller;
+    class SerialController;
+
+    /**
+     * Maximum number of strips a StripManager can run
+     */
+    const uint8_t maxStrips = 4;
+
+    /**
+     * Runs several Controllers from one loop, each driving its own output (see Controller::setLEDs(CLEDController&))
+     * with its own brightness and frame rate.
+     *
+     * mainloop draws at most one frame per call, for the strip whose frame has been due the longest,
+     * so a strip with a slow show (e.g. a long strip) holds the others back by at most one show and cannot starve them.
+     * One SerialController can address every strip, see setCommands.
+     */
+    class StripManager
+    {
+    private:
+        Controller *_strips[maxStrips];
+        uint8_t _numStrips;
+        SerialController *_commands;
+
+    public:
+        /**
+         * @brief Construct a new manager with no strips
+         */
+        StripManager();
+
+        /**
+         * @brief Add a strip to run.
+         * Only call mainloop on the manager, not on its strips.
+         * @param strip Controller to run, must outlive the manager
+         * @return int Strip number (from 0), -1 if it could not be added
+         */
+        int addStrip(Controller &strip);
+
+        /**
+         * @brief Read commands from the given SerialController on each mainloop call,
+         * and let its "strip" command select any of the strips.
+         * Batches started by its commands cover every strip.
+         * @param commands SerialController reading the commands, added as a strip if it is not one already
+         */
+        void setCommands(SerialController &commands);
+
+        /**
+         * @brief Get a strip
+         * @param idx Strip number
+         * @return Controller* NULL if there is no such strip
+         */
+        Controller* getStrip(uint8_t idx);
+        /**
+         * @brief Get the number of strips
+         * @return uint8_t
+         */
+        uint8_t getNumStrips();
+
+        /**
+         * Main loop method of the manager.
+         * Reads commands, draws the frame of the strip that has been waiting longest (if any frame is due),
+         * and commits changed settings of every strip.
+         * @return true A frame was drawn
+         */
+        bool mainloop();
+
+        /**
+         * @brief Get the time until the next frame of any strip is due
+         * @return unsigned long Microseconds, 0 if a frame is due
+         */
+        unsigned long timeUntilFrame();
+
+        /**
+         * Start a batch on every strip, see Controller::beginBatch
+         */
+        void beginBatch();
+        /**
+         * Apply the batch on every strip, or undo it on all of them if any failed
+         * @return true The batch was applied
+         */
+        bool commitBatch();
+        /**
+         * Mark the batch as invalid on every strip
+         */
+        void failBatch();
+        /**
+         * Undo the batch on every strip
+         */
+        void abortBatch();
+
+        /**
+         * Write any changed settings of every strip to EEPROM immediately
+         */
+        void save();
+    };
+};
+
+#endif